@@ -0,0 +1,335 @@
+#ifndef backend_H__
+#define backend_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "stream.hpp"
+#include "scoped.hpp"
+#include "scan.hpp"
+#include "jit.hpp"
+
+namespace backend {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// The backends which translate a program rather than interpret it: emitC prints it as a C translation
+// unit, writeStandalone writes it as an x86-64 executable, and runNative compiles it to native code
+// and runs that; emitCommands compiles a span of it, eg. a loop, for a tier above an interpreter.
+// They all take a program as ops, one per command word of whichever encoding a version has, as that
+// version decodes them; operand words and whatever only the interpreter cares about decode to NOP,
+// so that branch distances come out the same as in the encoding.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum Kind {
+	NOP,
+	ADD_WORD, // word at disp += value
+	SET_WORD, // word at disp = value
+	MOVE_PTR, // data pointer += delta
+	COND_L,   // '[', delta commands ahead of its COND_R
+	COND_R,   // ']', delta commands past its COND_L
+	INPUT,    // word at disp = input
+	OUTPUT,   // output word at disp
+	MUL_ADD,  // word at disp += current word * value
+	SCAN      // data pointer += delta while the current word is non-zero
+};
+
+struct Op {
+	Kind kind;
+	int8_t disp;   // displacement of the word operated on, from the current one
+	uint8_t value; // word added, set, or multiplied by
+	int32_t delta; // pointer move, or branch distance
+};
+
+// farthest word from the current one an op may address, as displacements are 8-bit
+enum { disp_range = 128 };
+
+template < typename T >
+class generic_free {
+public:
+	void operator()(T* arg) {
+		free(arg);
+	}
+};
+
+// runtime of the C translation of a program: tape, padded by TAPE_MARGIN words either side, buffered output and input
+static const char c_runtime[] =
+	"#include <stdio.h>\n"
+	"\n"
+	"static unsigned char tape[TAPE_MARGIN + MEMORY_SIZE + TAPE_MARGIN];\n"
+	"static char out[1 << 16];\n"
+	"static size_t out_len;\n"
+	"static int in;\n"
+	"\n"
+	"static void flush(void) {\n"
+	"\tfwrite(out, 1, out_len, stdout);\n"
+	"\tfflush(stdout);\n"
+	"\tout_len = 0;\n"
+	"}\n"
+	"\n"
+	"static void put(const unsigned char word) {\n"
+	"\tif (sizeof(out) - out_len < 4)\n"
+	"\t\tflush();\n"
+	"\n"
+	"#if PRINT_ASCII\n"
+	"\tout[out_len++] = (char) word;\n"
+	"\n"
+	"#else\n"
+	"\tif (word >= 100)\n"
+	"\t\tout[out_len++] = (char) ('0' + word / 100);\n"
+	"\tif (word >= 10)\n"
+	"\t\tout[out_len++] = (char) ('0' + word / 10 % 10);\n"
+	"\tout[out_len++] = (char) ('0' + word % 10);\n"
+	"\tout[out_len++] = ' ';\n"
+	"\n"
+	"#endif\n"
+	"}\n"
+	"\n"
+	"static unsigned char get(void) {\n"
+	"\tflush();\n"
+	"\tconst int nread = scanf(\"%d\", &in);\n"
+	"\t(void) nread;\n"
+	"\treturn (unsigned char) in;\n"
+	"}\n"
+	"\n"
+	"int main(void) {\n"
+	"\tunsigned char* p = tape + TAPE_MARGIN;\n"
+	"\n";
+
+// print the address of the word at displacement disp from the current one, in the C translation
+static void emitCWord(
+	stream::out& out,
+	const int disp) {
+
+	if (0 == disp)
+		out << "p[0]";
+	else
+		out << "p[" << int32_t(disp) << "]";
+}
+
+// print a program as a self-contained C translation unit, to be built separately, eg. with the flags of
+// build.sh; filename is that of its source, for the header comment
+static void emitC(
+	stream::out& out,
+	const Op* const program,
+	const size_t programLength,
+	const size_t dataLength,
+	const bool print_ascii,
+	const char* const filename) {
+
+	out << "// generated by brinterp -emit-c from " << filename << "\n"
+		"#define MEMORY_SIZE " << dataLength << "\n"
+		"#define TAPE_MARGIN " << int32_t(disp_range) << "\n"
+		"#define PRINT_ASCII " << int32_t(print_ascii) << "\n" << c_runtime;
+
+	size_t depth = 1;
+
+	for (size_t i = 0; i < programLength; ++i) {
+		const Op op = program[i];
+
+		if (NOP == op.kind)
+			continue;
+
+		if (COND_R == op.kind)
+			--depth;
+
+		for (size_t k = 0; k < depth; ++k)
+			out << '\t';
+
+		switch (op.kind) {
+		case NOP:
+			break;
+		case ADD_WORD:
+			emitCWord(out, op.disp);
+			out << " += " << uint32_t(op.value) << ";\n";
+			break;
+		case SET_WORD:
+			emitCWord(out, op.disp);
+			out << " = " << uint32_t(op.value) << ";\n";
+			break;
+		case MOVE_PTR:
+			out << "p " << (0 < op.delta ? "+= " : "-= ") << int32_t(0 < op.delta ? op.delta : -op.delta) << ";\n";
+			break;
+		case COND_L:
+			out << "while (p[0]) {\n";
+			++depth;
+			break;
+		case COND_R:
+			out << "}\n";
+			break;
+		case INPUT:
+			emitCWord(out, op.disp);
+			out << " = get();\n";
+			break;
+		case OUTPUT:
+			out << "put(";
+			emitCWord(out, op.disp);
+			out << ");\n";
+			break;
+		case MUL_ADD:
+			emitCWord(out, op.disp);
+			out << " += p[0] * " << uint32_t(op.value) << ";\n";
+			break;
+		case SCAN:
+			out << "while (p[0]) p " << (0 < op.delta ? "+= " : "-= ") << int32_t(0 < op.delta ? op.delta : -op.delta) << ";\n";
+			break;
+		}
+	}
+
+	out << "\n\tflush();\n\treturn 0;\n}\n";
+}
+
+#if __x86_64__
+// write a program as a standalone x86-64 executable, with a zeroed tape of dataLength words; return false on failure
+static bool writeStandalone(
+	const Op* const program,
+	const size_t programLength,
+	const size_t dataLength,
+	const bool print_ascii,
+	const char* const filename) {
+
+	using testbed::scoped_ptr;
+
+	// tape, followed by the output buffer, in .bss; ops may touch words up to disp_range either side of the
+	// tape, eg. closed-form loops which do not run, so keep that much of .bss around it
+	const uint64_t bss = uint64_t(1) << 32;
+	const uint64_t tape = bss + disp_range;
+	const uint64_t out = tape + ((dataLength + 2 * disp_range - 1) & ~uint64_t(disp_range - 1));
+
+	jit::Code code(programLength * jit::Code::max_command_size + sizeof(jit::runtime) + jit::Code::max_frame_size);
+	const scoped_ptr< size_t, generic_free > loop(
+		reinterpret_cast< size_t* >(calloc(programLength + 1, sizeof(size_t))));
+
+	if (!code.valid() || 0 == loop())
+		return false;
+
+	const size_t rt = code.emitRuntime();
+	const size_t entry = code.size();
+
+	code.start(tape, out);
+
+	for (size_t i = 0; i < programLength; ++i) {
+		const Op op = program[i];
+
+		switch (op.kind) {
+		case NOP:
+			break;
+		case ADD_WORD:
+			code.addWord(op.disp, op.value);
+			break;
+		case SET_WORD:
+			code.setWord(op.disp, op.value);
+			break;
+		case MOVE_PTR:
+			code.movePtr(op.delta);
+			break;
+		case COND_L:
+			loop()[i] = code.condL();
+			break;
+		case COND_R:
+			code.condR(loop()[i - op.delta]);
+			break;
+		case INPUT:
+			code.getWord(op.disp, rt);
+			break;
+		case OUTPUT:
+			code.putWord(op.disp, print_ascii, rt);
+			break;
+		case MUL_ADD:
+			code.mulAdd(op.disp, op.value);
+			break;
+		case SCAN:
+			code.scanInline(int8_t(op.delta));
+			break;
+		}
+	}
+
+	code.finish(rt);
+
+	return jit::writeElf(filename, code, entry, bss, out - bss + jit::runtime_out_size);
+}
+
+// emit the native code of the commands [begin, end) of a program, doing I/O by the given functions; loop holds
+// the code positions of the branches, by their program positions
+static void emitCommands(
+	jit::Code& code,
+	const Op* const program,
+	const size_t begin,
+	const size_t end,
+	const bool print_ascii,
+	const jit::input_t input,
+	const jit::output_t output,
+	size_t* const loop) {
+
+	for (size_t i = begin; i < end; ++i) {
+		const Op op = program[i];
+
+		switch (op.kind) {
+		case NOP:
+			break;
+		case ADD_WORD:
+			code.addWord(op.disp, op.value);
+			break;
+		case SET_WORD:
+			code.setWord(op.disp, op.value);
+			break;
+		case MOVE_PTR:
+			code.movePtr(op.delta);
+			break;
+		case COND_L:
+			loop[i] = code.condL();
+			break;
+		case COND_R:
+			code.condR(loop[i - op.delta]);
+			break;
+		case INPUT:
+			code.input(op.disp, input);
+			break;
+		case OUTPUT:
+			code.output(op.disp, print_ascii, output);
+			break;
+		case MUL_ADD:
+			code.mulAdd(op.disp, op.value);
+			break;
+		case SCAN:
+			code.scan(int8_t(op.delta), scan::seek_zero_fwd, scan::seek_zero_rev);
+			break;
+		}
+	}
+}
+
+// compile a program to native code, and run that on the data memory, doing I/O by the given functions; return
+// false if not possible
+static bool runNative(
+	const Op* const program,
+	const size_t programLength,
+	uint8_t* const mem,
+	const size_t dataLength,
+	const bool print_ascii,
+	const jit::input_t input,
+	const jit::output_t output) {
+
+	using testbed::scoped_ptr;
+
+	jit::Code code(programLength * jit::Code::max_command_size + jit::Code::max_frame_size);
+	const scoped_ptr< size_t, generic_free > loop(
+		reinterpret_cast< size_t* >(calloc(programLength + 1, sizeof(size_t))));
+
+	if (!code.valid() || 0 == loop())
+		return false;
+
+	code.prologue();
+	emitCommands(code, program, 0, programLength, print_ascii, input, output, loop());
+	code.epilogue();
+
+	const jit::entry_t entry = code.finalize();
+
+	if (0 == entry)
+		return false;
+
+	entry(mem, dataLength);
+	return true;
+}
+
+#endif
+} // namespace backend
+
+#endif // backend_H__
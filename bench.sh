@@ -0,0 +1,40 @@
+#!/bin/bash
+
+set -euo pipefail
+
+# usage: bench.sh [<runs>]; builds the vanilla version with $CXX, times every workload that many runs
+# in-process, and writes the statistics to bench.json, printing them as a README-ready table
+runs=${1:-10}
+workloads=(mandelbrot.bf hello.bf corpus/*.bf)
+
+./build.sh
+
+json=()
+
+for w in "${workloads[@]}"; do
+	# the statistics are the last line on stderr; the program's own output goes away
+	stats=$(./brinterp -repeat "$runs" "$w" 2>&1 >/dev/null | tail -n 1)
+	json+=("{\"workload\": \"$w\", ${stats#\{}")
+done
+
+{
+	echo "["
+	for i in "${!json[@]}"; do
+		sep=","
+		[ $((i + 1)) -eq ${#json[@]} ] && sep=""
+		echo "	${json[$i]}$sep"
+	done
+	echo "]"
+} > bench.json
+
+echo "| workload        | runs | min (s)    | median (s) | stddev (s) | GHz    | median cycles  |"
+echo "| --------------- | ---- | ---------- | ---------- | ---------- | ------ | -------------- |"
+
+for j in "${json[@]}"; do
+	echo "$j" | tr -d '{}":,' | awk '{
+		for (i = 1; i < NF; i += 2)
+			v[$i] = $(i + 1)
+		printf "| %-15s | %4d | %10.6f | %10.6f | %10.6f | %6.3f | %14.0f |\n",
+			v["workload"], v["runs"], v["min_ns"] * 1e-9, v["median_ns"] * 1e-9, v["stddev_ns"] * 1e-9, v["ghz"], v["median_cycles"]
+	}'
+done
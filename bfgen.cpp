@@ -0,0 +1,170 @@
+// bfgen: generate synthetic workloads, each stressing a single kind of op or idiom, for per-op cost microbenchmarks
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include "stream.hpp"
+
+namespace stream {
+// deferred initialization by main()
+in cin;
+out cout;
+out cerr;
+} // namespace stream
+
+enum Kind {
+	KIND_ADD,       // runs of '+' over a row of words
+	KIND_PING_PONG, // data-pointer moves back and forth
+	KIND_NEST,      // deep loop nests of few iterations each
+	KIND_SCAN,      // '[>]' and '[<]' scans over a row of non-zero words
+	KIND_MUL,       // multiply loops
+	KIND_OUTPUT,    // output floods
+	KIND_HUGE,      // huge straight-line source, for translation throughput
+
+	KIND_COUNT
+};
+
+static const char* const kind_name[KIND_COUNT] = {
+	"add",
+	"ping_pong",
+	"nest",
+	"scan",
+	"mul",
+	"output",
+	"huge"
+};
+
+static const size_t default_size[KIND_COUNT] = {
+	64,     // '+' runs per body
+	64,     // round trips per body
+	4,      // nest depth
+	1024,   // row length
+	16,     // multiply loops per body
+	64,     // outputs per body
+	1 << 18 // straight-line units
+};
+
+static const size_t default_repeat = 1 << 20;
+
+// counters of the repeat loops; their steps are even, so that translation cannot fold the loops into closed forms
+enum { counter_count = 3 };
+enum { counter_max = 127 };
+
+// find the kind of the given name; return KIND_COUNT if none
+static size_t findKind(const char* const name) {
+	size_t kind = 0;
+
+	while (kind < KIND_COUNT && std::strcmp(kind_name[kind], name))
+		++kind;
+
+	return kind;
+}
+
+// emit str count times
+static void emit(
+	const char* const str,
+	const size_t count = 1) {
+
+	for (size_t i = 0; i < count; ++i)
+		stream::cout << str;
+}
+
+// emit the body of the given kind, from the first work word back to it
+static void emitBody(
+	const Kind kind,
+	const size_t size) {
+
+	switch (kind) {
+	case KIND_ADD:
+		// translation turns the moves into displacements, so the body runs as a string of adds
+		for (size_t i = 0; i < size; ++i) {
+			emit("+", 1 + i % 13);
+			emit(">");
+		}
+		emit("<", size);
+		break;
+	case KIND_PING_PONG:
+		// the loops keep the moves apart, which translation would fold otherwise
+		emit(">>[-]<<[-]", size);
+		break;
+	case KIND_NEST:
+		// two iterations per level, which the innermost multiplies by some work
+		emit(">++++[", size);
+		emit(">+<");
+		emit("--]<", size);
+		break;
+	case KIND_SCAN:
+		// there and back again, over the row set up by the prologue
+		emit(">[>]<[<]");
+		break;
+	case KIND_MUL:
+		emit(">+++++++[->+++>++<<]<", size);
+		break;
+	case KIND_OUTPUT:
+		emit("+.", size);
+		break;
+	default:
+		break;
+	}
+}
+
+int main(
+	int argc,
+	char** argv) {
+
+	stream::cin.open(stdin);
+	stream::cout.open(stdout);
+	stream::cerr.open(stderr);
+
+	const size_t kind = 1 < argc ? findKind(argv[1]) : size_t(KIND_COUNT);
+	size_t size = KIND_COUNT > kind ? default_size[kind] : 0;
+	size_t repeat = default_repeat;
+
+	if (KIND_COUNT <= kind || 4 < argc ||
+		(2 < argc && (1 != sscanf(argv[2], "%lu", &size) || 0 == size)) ||
+		(3 < argc && (1 != sscanf(argv[3], "%lu", &repeat) || 0 == repeat))) {
+
+		stream::cerr << "usage: " << argv[0] << " <kind> [<size> [<repeat>]]\n"
+			"kinds:";
+
+		for (size_t i = 0; i < KIND_COUNT; ++i)
+			stream::cerr << ' ' << kind_name[i] << " (default size " << uint64_t(default_size[i]) << ')';
+
+		stream::cerr << "\nthe body of the kind gets generated at that size, and run that many times, up to " << uint64_t(counter_max) * counter_max * counter_max << "; default is " << uint64_t(default_repeat) << "\n";
+		return 1;
+	}
+
+	if (KIND_HUGE == kind) {
+		// a single pass over the source, which has got loops for the branch linker to resolve
+		emit("+>>-<[-]<", size);
+		return 0;
+	}
+
+	// split the repeat count over the counters, innermost first
+	size_t counter[counter_count];
+	size_t left = repeat;
+
+	for (size_t i = 0; i < counter_count; ++i) {
+		counter[i] = counter_max < left ? counter_max : left;
+		left = (left + counter[i] - 1) / counter[i];
+	}
+
+	// the work words start right past the counters
+	if (KIND_SCAN == kind) {
+		emit(">", counter_count + 1);
+		emit("+>", size);
+		emit("<", counter_count + 1 + size);
+	}
+
+	for (size_t i = counter_count; 0 != i--;) {
+		emit("+", 2 * counter[i]);
+		emit("[>");
+	}
+
+	emitBody(Kind(kind), size);
+
+	for (size_t i = 0; i < counter_count; ++i)
+		emit("<--]");
+
+	stream::cout << '\n';
+	return 0;
+}
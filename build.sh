@@ -14,6 +14,7 @@ CXXFLAGS=(
 	-DNDEBUG
 	-DPRINT_ASCII=1
 	-DENABLE_DIAGNOSTICS=0
+	-DQUICKEN=0
 )
 if [[ $UNAME_MACHINE == "aarch64" ]] ; then
 
@@ -24,6 +25,11 @@ elif [[ $UNAME_MACHINE == "arm64" ]] ; then
 			-march=armv8.4-a # baseline for macos/arm64
 			-mtune=native
 		)
+elif [[ -n ${PORTABLE:-} && $UNAME_MACHINE == "x86_64" ]] ; then
+		# portable artifact: baseline ISA, with the interpreter loop multiversioned and picked at startup
+		CXXFLAGS+=(
+			-DMULTIVERSION=1
+		)
 else
 		CXXFLAGS+=(
 			-march=native
@@ -32,4 +38,20 @@ else
 fi
 
 # set -x
-${CXX} ${CXXFLAGS[@]} main${1}.cpp util_file.cpp -o brinterp
+if [[ $1 == "_cnp" && $UNAME_MACHINE == "x86_64" ]] ; then
+	# copy-and-patch engine: compile the stencils for absolute addressing of their holes, and extract them into a table
+	${CXX} ${CXXFLAGS[@]} -mcmodel=large -fno-pic -fno-asynchronous-unwind-tables -ffunction-sections -fno-stack-protector -fcf-protection=none -c stencils.cpp -o stencils.o &&
+	${CXX} ${CXXFLAGS[@]} stencil_gen.cpp util_file.cpp -o stencil_gen &&
+	./stencil_gen stencils.o > stencils.inc || exit 1
+fi
+
+SUFFIX=$1
+
+if [[ $SUFFIX == "_tail" ]] && ! printf '#if !defined(__has_attribute) || !__has_attribute(musttail)\n#error\n#endif\n' | ${CXX} -x c++ -fsyntax-only - 2>/dev/null ; then
+	# tail-call-threaded engine: without musttail, fall back to the computed-goto one
+	echo "$CXX lacks musttail; building _thr in place of _tail" >&2
+	SUFFIX=_thr
+fi
+
+# extra flags, eg. those of a profile-guided build, go to the interpreter alone
+${CXX} ${CXXFLAGS[@]} ${EXTRA_CXXFLAGS:-} main${SUFFIX}.cpp util_file.cpp -o brinterp
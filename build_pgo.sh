@@ -0,0 +1,34 @@
+#!/bin/bash
+
+# profile-guided and link-time optimised build of the version of the given suffix, as of build.sh: build an
+# instrumented interpreter, train it on mandelbrot.bf and the corpus, and rebuild it by the profile, with LTO
+
+set -euo pipefail
+
+CXX=${CXX:-g++}
+PROFILE_DIR=`pwd`/pgo${1:-}
+
+rm -rf $PROFILE_DIR
+mkdir -p $PROFILE_DIR
+
+if [[ `$CXX --version` == *clang* ]] ; then
+	PROFDATA=`which llvm-profdata || ls /usr/bin/llvm-profdata-* 2>/dev/null | sort -V | tail -1`
+	GENERATE_FLAGS="-fprofile-instr-generate=$PROFILE_DIR/%p.profraw"
+	USE_FLAGS="-fprofile-instr-use=$PROFILE_DIR/brinterp.profdata -flto"
+else
+	GENERATE_FLAGS="-fprofile-generate=$PROFILE_DIR"
+	USE_FLAGS="-fprofile-use=$PROFILE_DIR -flto"
+fi
+
+EXTRA_CXXFLAGS="$GENERATE_FLAGS" ./build.sh ${1:-}
+
+for src in mandelbrot.bf corpus/*.bf ; do
+	./brinterp $src < /dev/null > /dev/null
+done
+
+if [[ `$CXX --version` == *clang* ]] ; then
+	$PROFDATA merge -o $PROFILE_DIR/brinterp.profdata $PROFILE_DIR/*.profraw
+fi
+
+EXTRA_CXXFLAGS="$USE_FLAGS" ./build.sh ${1:-}
+rm -rf $PROFILE_DIR
@@ -0,0 +1,3 @@
+[ output heavy: print a word in loops and step it as it goes ]
+++++++++[>++++++++<-]>+
+>--[>--[>--[<<<.+>>>--]<--]<--]
@@ -0,0 +1,3 @@
+[ multiply heavy: closed form multiply loops within loops of even counter steps ]
+--[>--[>--[>+++++[>+++>+++++>+++++++<<<-]>[>+<-]>>[<<+>>-]<<<<--]<--]<--]
+>>>>.>.>.
@@ -0,0 +1,3 @@
+[ scan heavy: fill a run of ones and sweep it end to end with scan loops ]
+>>>>++++++++[<++++++++++++++++>-]<[->>[>]+[<]<]
+<<<--[>--[>--[>>>[>]<[<]<<-]<--]<--]
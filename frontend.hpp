@@ -0,0 +1,1201 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// The front end the versions other than vanilla share: command line, command encoding, translation of the
+// source into commands, and main(), which hands the translated program to the backends or to the run loop
+// of the version. A version defines the knobs below as it needs, includes this, then defines its run loop
+// and the interpret() hook main() ends in. There is no include guard: the all-engines build includes
+// this once per version, each within a namespace of its own.
+//
+// NIBBLE_OPCODE -- encode commands as a 4-bit opcode and an immediate above it, rather than by opcode class
+// POLICY_OPTION -- take an interpreter-loop policy index by -policy
+// SPLIT_PROGRAM -- the version runs a layout of its own rather than the compact or wide command form
+// CODE_SPACE(n) -- bytes the version takes ahead of the tape for a program of n commands
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <cassert>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include "stream.hpp"
+#include "scoped.hpp"
+#include "util_file.hpp"
+#include "scan.hpp"
+#include "jit.hpp"
+#include "backend.hpp"
+
+// verify iostream-free status
+#if _GLIBCXX_IOSTREAM
+#error rogue iostream acquired
+#endif
+
+namespace stream {
+// deferred initialization by main()
+in cin;
+out cout;
+out cerr;
+} // namespace stream
+
+static const char arg_prefix[]         = "-";
+static const char arg_memory_size[]    = "memory_size";
+static const char arg_terminal_count[] = "terminal_count";
+static const char arg_print_ascii[]    = "print_ascii";
+static const char arg_jit[]            = "jit";
+static const char arg_emit_c[]         = "emit-c";
+static const char arg_output[]         = "o";
+#if POLICY_OPTION
+static const char arg_policy[]         = "policy";
+
+#endif
+
+static const size_t default_memory_size_kw = 32;
+static const size_t default_terminal_count = 4096;
+static const size_t mempage_size = 4096;
+#if __LP64__ == 1
+static const size_t cacheline_size = 64;
+
+#else
+static const size_t cacheline_size = 32;
+
+#endif
+
+struct cli_param {
+	enum {
+		FLAG_PRINT_ASCII = 1,
+		FLAG_JIT         = 2,
+		FLAG_EMIT_C      = 4,
+		FLAG_POLICY      = 8
+	};
+	uint64_t terminalCount;
+
+	uint32_t memorySize;
+	uint32_t flags;
+
+	const char* filename;
+	const char* output;
+
+#if POLICY_OPTION
+	uint32_t policy;
+
+#endif
+};
+
+static int __attribute__ ((noinline)) parse_cli(
+	const int argc,
+	char** const argv,
+	cli_param& param) {
+
+	const unsigned prefix_len = std::strlen(arg_prefix);
+	bool success = true;
+
+	param.filename = 0;
+
+	for (int i = 1; i < argc && success; ++i) {
+		if (std::strncmp(argv[i], arg_prefix, prefix_len)) {
+			if (0 != param.filename)
+				success = false;
+
+			param.filename = argv[i];
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_memory_size)) {
+			if (++i == argc || 1 != sscanf(argv[i], "%u", &param.memorySize))
+				success = false;
+
+			continue;
+		}
+
+#if ENABLE_DIAGNOSTICS
+		if (!std::strcmp(argv[i] + prefix_len, arg_terminal_count)) {
+			if (++i == argc || 1 != sscanf(argv[i], "%lu", &param.terminalCount))
+				success = false;
+
+			continue;
+		}
+
+#endif
+#if PRINT_ASCII == 0
+		if (!std::strcmp(argv[i] + prefix_len, arg_print_ascii)) {
+			param.flags |= size_t(cli_param::FLAG_PRINT_ASCII);
+			continue;
+		}
+
+#endif
+		if (!std::strcmp(argv[i] + prefix_len, arg_jit)) {
+			param.flags |= size_t(cli_param::FLAG_JIT);
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_emit_c)) {
+			param.flags |= size_t(cli_param::FLAG_EMIT_C);
+			continue;
+		}
+
+#if POLICY_OPTION
+		if (!std::strcmp(argv[i] + prefix_len, arg_policy)) {
+			if (++i == argc || 1 != sscanf(argv[i], "%u", &param.policy))
+				success = false;
+
+			param.flags |= size_t(cli_param::FLAG_POLICY);
+			continue;
+		}
+
+#endif
+		if (!std::strcmp(argv[i] + prefix_len, arg_output)) {
+			if (++i == argc)
+				success = false;
+			else
+				param.output = argv[i];
+
+			continue;
+		}
+
+		success = false;
+	}
+
+	if (!success || 0 == param.filename) {
+		stream::cerr << "usage: " << argv[0] << " [<option> ...] <source_filename>\n"
+			"options (multiple args to an option must constitute a single string, eg. -foo \"a b c\"):\n"
+			"\t" << arg_prefix << arg_memory_size << " <positive_integer>\t\t: amount of memory available to program, in words; default is " << default_memory_size_kw << "Kwords\n"
+
+#if ENABLE_DIAGNOSTICS
+			"\t" << arg_prefix << arg_terminal_count << " <positive_integer>\t: number of steps after which program is forcefully terminated; default is " << default_terminal_count << "\n"
+
+#endif
+#if PRINT_ASCII == 0
+			"\t" << arg_prefix << arg_print_ascii << "\t\t\t\t: print in ASCII instead of numbers\n"
+
+#endif
+			"\t" << arg_prefix << arg_jit << "\t\t\t\t\t: compile program to native code, where supported; default is interpreting\n"
+			"\t" << arg_prefix << arg_emit_c << "\t\t\t\t: print program as a self-contained C translation unit instead of running it\n"
+			"\t" << arg_prefix << arg_output << " <filename>\t\t\t: write program as a standalone x86-64 executable instead of running it\n"
+
+#if POLICY_OPTION
+			"\t" << arg_prefix << arg_policy << " <index>\t\t\t: interpreter-loop policy, as a sum of 1: cached word, 2: branchless branches, 4: assumed opcode range; default is 3\n"
+
+#endif
+			;
+		return 1;
+	}
+
+	return 0;
+}
+
+typedef uint8_t word_t; // machine word type
+
+template < typename T >
+class generic_free {
+public:
+	void operator()(T* arg) {
+		assert(0 != arg);
+		free(arg);
+	}
+};
+
+template < bool >
+struct compile_assert;
+
+template <>
+struct compile_assert< true > {
+	compile_assert() {}
+};
+
+#if NIBBLE_OPCODE
+enum Opcode {
+	OPCODE_ADD_WORD, // '+' and '-', repetitions of, mod word range
+	OPCODE_ADD_PTR,  // '>', repetitions of
+	OPCODE_SUB_PTR,  // '<', repetitions of
+	OPCODE_COND_L,   // '['
+	OPCODE_COND_R,   // ']'
+	OPCODE_INPUT,    // '.'
+	OPCODE_OUTPUT,   // ','
+	OPCODE_SET_WORD, // '[-]' or '[+]', followed by repetitions of '+' and '-'
+	OPCODE_MUL_ADD,  // closed-form loop: word at displacement += word * factor, both from operand word
+	OPCODE_SCAN,     // '[>]' or '[<]', repetitions of either within: seek word 0 by stride from operand word
+	OPCODE_ADD_WORD_AT, // as OPCODE_ADD_WORD, at displacement from operand word
+	OPCODE_INPUT_AT,    // as OPCODE_INPUT, at displacement from operand word
+	OPCODE_OUTPUT_AT,   // as OPCODE_OUTPUT, at displacement from operand word
+};
+
+template < typename STORE_T >
+class Command {
+	STORE_T op; // encoding uses unsigned immediates (direction determined by the type of op)
+
+	Command(); // undefined
+
+public:
+	enum { imm_range = 1 << (8 * sizeof(STORE_T) - 4) };
+	enum { branch_range = imm_range };    // all immediates share the one range
+	enum { ptr_arith_range = imm_range };
+
+	Command(
+		const Opcode an_op,
+		const STORE_T an_imm) {
+
+		assert(imm_range > an_imm);
+
+		op = STORE_T(an_op) | STORE_T(an_imm << 4);
+	}
+
+	// operand word of a multi-word op
+	Command(
+		const Opcode,
+		const int8_t a_disp,
+		const word_t a_value)
+	: op(STORE_T(uint8_t(a_disp) << 8 | a_value)) {
+	}
+
+	Opcode getOp() const {
+
+		return Opcode(op & STORE_T(0xf));
+	}
+
+	size_t getImm() const {
+		return size_t(op >> 4);
+	}
+
+	// is this followed by an operand word?
+	bool hasOperand() const {
+		switch (getOp()) {
+		case OPCODE_MUL_ADD:
+		case OPCODE_SCAN:
+		case OPCODE_ADD_WORD_AT:
+		case OPCODE_INPUT_AT:
+		case OPCODE_OUTPUT_AT:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	int8_t getDisp() const {
+		return int8_t(op >> 8);
+	}
+
+	word_t getValue() const {
+		return word_t(op);
+	}
+};
+
+#else
+enum Opcode {
+	OPCODE_INPUT,             // '.'
+	OPCODE_OUTPUT,            // ','
+	OPCODE_MUL_ADD,           // closed-form loop: word at displacement += word * factor, both from operand word
+	OPCODE_SCAN,              // '[>]' or '[<]', repetitions of either within: seek word 0 by stride from operand word
+	OPCODE_ADD_WORD_AT,       // as OPCODE_ADD_WORD, at displacement from operand word
+	OPCODE_INPUT_AT,          // as OPCODE_INPUT, at displacement from operand word
+	OPCODE_OUTPUT_AT,         // as OPCODE_OUTPUT, at displacement from operand word
+	OPCODE_SET_WORD = 0x4000, // '[-]' or '[+]', followed by repetitions of '+' and '-'
+	OPCODE_COND_L   = 0x8000, // '['
+	OPCODE_COND_R   = 0xc000, // ']'
+	OPCODE_ADD_WORD = 0x1000, // '+' and '-', repetitions of, mod word range
+	OPCODE_ADD_PTR  = 0x2000, // '>', repetitions of
+	OPCODE_SUB_PTR  = 0x3000, // '<', repetitions of
+};
+
+template < typename STORE_T >
+class Command {
+	STORE_T op; // encoding uses unsigned immediates (direction determined by the type of op)
+
+	// opcode classes sit at the top of the word, so shift them there from their 16-bit positions
+	enum { class_shift = 8 * (sizeof(STORE_T) - sizeof(uint16_t)) };
+
+	Command(); // undefined
+
+public:
+	enum { branch_range = 1 << (8 * sizeof(STORE_T) - 2) };
+	enum { ptr_arith_range = 1 << (8 * sizeof(STORE_T) - 4) };
+
+	Command(
+		const Opcode an_op,
+		const STORE_T an_imm) {
+
+		switch (an_op) {
+		case OPCODE_COND_L:
+		case OPCODE_COND_R:
+		case OPCODE_ADD_WORD:
+		case OPCODE_ADD_PTR:
+		case OPCODE_SUB_PTR:
+		case OPCODE_SET_WORD:
+			op = STORE_T(an_op) << class_shift | an_imm;
+			break;
+		default:
+			op = an_op;
+		}
+	}
+
+	// operand word of a multi-word op
+	Command(
+		const Opcode,
+		const int8_t a_disp,
+		const word_t a_value)
+	: op(STORE_T(uint8_t(a_disp) << 8 | a_value)) {
+	}
+
+	Opcode getOp() const {
+
+		// is this a conditional branch or word assignment?
+		if (op & STORE_T(0xc000) << class_shift)
+			return Opcode(op >> class_shift & 0xc000);
+
+		// is this word or ptr arithmetics?
+		if (op & STORE_T(0x3000) << class_shift)
+			return Opcode(op >> class_shift & 0x3000);
+
+		return Opcode(op);
+	}
+
+	STORE_T getOffset() const {
+		return op & ~(STORE_T(0xc000) << class_shift);
+	}
+
+	STORE_T getArith() const {
+		return op & ~(STORE_T(0x3000) << class_shift);
+	}
+
+	// is this followed by an operand word?
+	bool hasOperand() const {
+		switch (getOp()) {
+		case OPCODE_MUL_ADD:
+		case OPCODE_SCAN:
+		case OPCODE_ADD_WORD_AT:
+		case OPCODE_INPUT_AT:
+		case OPCODE_OUTPUT_AT:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	int8_t getDisp() const {
+		return int8_t(op >> 8);
+	}
+
+	word_t getValue() const {
+		return word_t(op);
+	}
+};
+
+#endif
+typedef Command< uint16_t > Command16; // compact form, for programs whose immediates fit
+typedef Command< uint32_t > Command32; // wide form, for translation, and for programs that do not fit the compact one
+
+namespace {
+const compile_assert< 2 == sizeof(Command16) > assert_sizeof_command16;
+const compile_assert< 4 == sizeof(Command32) > assert_sizeof_command32;
+} // namespace annonymous
+
+static size_t seekBalancedClose(
+	const Command32* const program,
+	const size_t programLength) {
+
+	size_t count = 0;
+	size_t pos = 0;
+
+	while (++pos < programLength) {
+		if (program[pos].hasOperand()) {
+			++pos; // skip operand word
+			continue;
+		}
+		if (program[pos].getOp() == OPCODE_COND_L) {
+			++count;
+			continue;
+		}
+		if (program[pos].getOp() == OPCODE_COND_R) {
+			if (0 == count)
+				return pos;
+			--count;
+		}
+	}
+
+	return 0;
+}
+
+static bool is_nop(const char op) {
+	return
+		op != '+' &&
+		op != '-' &&
+		op != '>' &&
+		op != '<' &&
+		op != '[' &&
+		op != ']' &&
+		op != ',' &&
+		op != '.';
+}
+
+// seek the end of a run of '+' and '-', starting at pos; return the run's net sum in arith
+static size_t seekArithRun(
+	const char* const source,
+	const size_t sourceLength,
+	size_t pos,
+	int& arith) {
+
+	for (arith = 0; pos < sourceLength; ++pos) {
+		if ('+' == source[pos])
+			++arith;
+		else
+		if ('-' == source[pos])
+			--arith;
+		else
+		if (!is_nop(source[pos]))
+			break;
+	}
+
+	return pos;
+}
+
+// seek the end of a scan loop, like '[>]' or '[<<<]', starting at its '['; return 0 if not such a loop
+static size_t seekScanLoop(
+	const char* const source,
+	const size_t sourceLength,
+	size_t pos,
+	int& stride) {
+
+	for (stride = 0; ++pos < sourceLength; ) {
+		if ('>' == source[pos])
+			++stride;
+		else
+		if ('<' == source[pos])
+			--stride;
+		else
+		if (']' == source[pos])
+			return 0 != stride && int8_t(stride) == stride ? pos + 1 : 0;
+		else
+		if (!is_nop(source[pos]))
+			return 0;
+	}
+
+	return 0;
+}
+
+// seek the ']' matching the '[' at pos; return 0 if unmatched
+static size_t seekSourceClose(
+	const char* const source,
+	const size_t sourceLength,
+	size_t pos) {
+
+	size_t count = 0;
+
+	while (++pos < sourceLength) {
+		if ('[' == source[pos]) {
+			++count;
+			continue;
+		}
+		if (']' == source[pos]) {
+			if (0 == count)
+				return pos;
+			--count;
+		}
+	}
+
+	return 0;
+}
+
+// multiplicative inverse of an odd word, mod word range
+static word_t inverse(const word_t a) {
+	word_t x = a; // correct to 3 bits for any odd a; each newton step doubles that
+
+	x *= word_t(2 - a * x);
+	x *= word_t(2 - a * x);
+	return x;
+}
+
+enum { fold_range = 64 }; // farthest word from the counter a closed-form loop may touch
+enum { fold_span = 2 * fold_range + 1 };
+
+// affine form c + sum(coef[k] * w[k]) over the words w[] around a loop counter, as found at loop entry
+struct Affine {
+	word_t coef[fold_span];
+	word_t c;
+
+	void setVar(const size_t k) {
+		std::memset(coef, 0, sizeof(coef));
+		coef[k] = 1;
+		c = 0;
+	}
+
+	void setConst(const word_t a) {
+		std::memset(coef, 0, sizeof(coef));
+		c = a;
+	}
+
+	bool isConst() const {
+		for (size_t k = 0; k < fold_span; ++k)
+			if (0 != coef[k])
+				return false;
+
+		return true;
+	}
+
+	// is this the argument form stepped by a constant?
+	bool isStepOf(const Affine& a) const {
+		return 0 == std::memcmp(coef, a.coef, sizeof(coef));
+	}
+
+	void addScaled(const Affine& a, const word_t factor) {
+		for (size_t k = 0; k < fold_span; ++k)
+			coef[k] += word_t(a.coef[k] * factor);
+
+		c += word_t(a.c * factor);
+	}
+};
+
+// symbolically run the body (begin, end) of a loop whose counter sits at word[fold_range]; the body may
+// contain word arithmetics, pointer moves, and inner loops of those which step their counters by an odd
+// constant and leave the data pointer where they found it; return false if the body is not such
+static bool evalLoopBody(
+	const char* const source,
+	const size_t begin,
+	const size_t end,
+	Affine (& word)[fold_span],
+	const bool inner = false) {
+
+	size_t pos = fold_range;
+
+	for (size_t i = begin; i < end; ++i) {
+		switch (source[i]) {
+		case '+':
+			++word[pos].c;
+			break;
+		case '-':
+			--word[pos].c;
+			break;
+		case '>':
+			if (fold_span == ++pos)
+				return false;
+			break;
+		case '<':
+			if (0 == pos--)
+				return false;
+			break;
+		case '[': {
+				const size_t close = seekSourceClose(source, end, i);
+
+				if (inner || 0 == close)
+					return false;
+
+				// run the inner body on a blank slate, so it leaves behind its per-iteration deltas
+				Affine delta[fold_span];
+
+				for (size_t k = 0; k < fold_span; ++k)
+					delta[k].setConst(0);
+
+				if (!evalLoopBody(source, i + 1, close, delta, true))
+					return false;
+
+				const word_t step = delta[fold_range].c;
+
+				if (0 == (step & 1))
+					return false;
+
+				// n = counter * inverse(-step) iterations, each adding delta to the rest of the words
+				const word_t step_inv = inverse(word_t(-step));
+
+				for (size_t k = 0; k < fold_span; ++k) {
+					if (fold_range == k || 0 == delta[k].c)
+						continue;
+
+					const size_t at = pos + k - fold_range;
+
+					if (at >= fold_span)
+						return false;
+
+					word[at].addScaled(word[pos], word_t(delta[k].c * step_inv));
+				}
+
+				word[pos].setConst(0);
+				i = close;
+			}
+			break;
+		case ']':
+		case ',':
+		case '.':
+			return false;
+		}
+	}
+
+	return fold_range == pos;
+}
+
+static bool translateSpan(
+	const char* const source,
+	const size_t begin,
+	const size_t end,
+	Command32* const program,
+	size_t& j);
+
+// translate the loop spanning [begin, end] in closed form: the loop must leave the data pointer where it
+// found it, step its counter by an odd constant, and leave each other word either intact, or stepped by
+// a constant; words that get set to a constant are admitted by running the first iteration as-is, and
+// folding the rest; return the source position past the translation, or 0 if not possible
+static size_t foldLoop(
+	const char* const source,
+	const size_t sourceLength,
+	const size_t begin,
+	const size_t end,
+	Command32* const program,
+	size_t& j,
+	bool& err) {
+
+	Affine entry[fold_span];
+	Affine word[fold_span];
+
+	for (size_t k = 0; k < fold_span; ++k)
+		entry[k].setVar(k);
+
+	bool peel = false;
+
+	for (size_t pass = 0; true; ++pass) {
+		for (size_t k = 0; k < fold_span; ++k)
+			word[k] = entry[k];
+
+		if (!evalLoopBody(source, begin + 1, end, word))
+			return 0;
+
+		if (!word[fold_range].isStepOf(entry[fold_range]) || 0 == (word[fold_range].c & 1))
+			return 0;
+
+		size_t k = 0;
+
+		while (k < fold_span && word[k].isStepOf(entry[k]))
+			++k;
+
+		if (fold_span == k) {
+			peel = 0 != pass;
+			break;
+		}
+
+		if (0 != pass)
+			return 0;
+
+		// words that the first iteration sets to a constant enter the remaining iterations as such
+		for (k = 0; k < fold_span; ++k)
+			if (fold_range != k && word[k].isConst())
+				entry[k].setConst(word[k].c);
+	}
+
+	if (peel) {
+		program[j++] = Command32(OPCODE_COND_L, 0); // defer offset calculation
+
+		if (translateSpan(source, begin + 1, end, program, j))
+			err = true;
+	}
+
+	const word_t step_inv = inverse(word_t(entry[fold_range].c - word[fold_range].c));
+
+	for (size_t k = 0; k < fold_span; ++k) {
+		const word_t factor = word_t((word[k].c - entry[k].c) * step_inv);
+
+		if (fold_range == k || 0 == factor)
+			continue;
+
+		program[j++] = Command32(OPCODE_MUL_ADD, 0);
+		program[j++] = Command32(OPCODE_MUL_ADD, int8_t(k - fold_range), factor); // operand word
+	}
+
+	if (peel) {
+		program[j++] = Command32(OPCODE_SET_WORD, 0);
+		program[j++] = Command32(OPCODE_COND_R, 0); // defer offset calculation
+		return end + 1;
+	}
+
+	int arith;
+	const size_t pos = seekArithRun(source, sourceLength, end + 1, arith);
+
+	program[j++] = Command32(OPCODE_SET_WORD, word_t(arith));
+	return pos;
+}
+
+// emit the data-pointer move pending at source position pos; return true on error
+static bool emitPtrMove(
+	const size_t pos,
+	Command32* const program,
+	size_t& j,
+	int& move) {
+
+	const Opcode op = 0 > move ? OPCODE_SUB_PTR : OPCODE_ADD_PTR;
+	const size_t len = size_t(0 > move ? -move : move);
+	bool err = false;
+
+	if (0 == move)
+		return err;
+
+	if (Command32::ptr_arith_range > len) {
+		program[j++] = Command32(op, uint32_t(len));
+	}
+	else {
+		program[j++] = Command32(op, 0);
+		stream::cerr << "program error: way too many '" << (0 > move ? '<' : '>') << "' at ip " << pos << '\n';
+		err = true;
+	}
+
+	move = 0;
+	return err;
+}
+
+// emit op, or its displaced form op_at, at the data-pointer move pending at source position pos; return true on error
+static bool emitAtPtrMove(
+	const Opcode op,
+	const Opcode op_at,
+	const word_t value,
+	const size_t pos,
+	Command32* const program,
+	size_t& j,
+	int& move) {
+
+	if (0 != move && int8_t(move) == move) {
+		program[j++] = Command32(op_at, 0);
+		program[j++] = Command32(op_at, int8_t(move), value); // operand word
+		return false;
+	}
+
+	const bool err = emitPtrMove(pos, program, j, move);
+
+	program[j++] = Command32(op, value);
+	return err;
+}
+
+// translate the source span [begin, end) into program, starting at program[j]; return true on error
+static bool translateSpan(
+	const char* const source,
+	const size_t begin,
+	const size_t end,
+	Command32* const program,
+	size_t& j) {
+
+	size_t i = begin;
+	bool err = false;
+	int move = 0; // data-pointer move pending since the last branch
+
+	while (i < end) {
+		size_t imm;
+		size_t skip;
+		int arith;
+
+		switch (source[i]) {
+		case '+':
+		case '-':
+			imm = seekArithRun(source, end, i, arith);
+			if (0 != word_t(arith) && emitAtPtrMove(OPCODE_ADD_WORD, OPCODE_ADD_WORD_AT, word_t(arith), i, program, j, move))
+				err = true;
+			i = imm - 1;
+			break;
+		case '>':
+			for (imm = i + 1, skip = 0; imm < end; ++imm) {
+				if (is_nop(source[imm]))
+					++skip;
+				else
+				if ('>' != source[imm])
+					break;
+			}
+			if (Command32::ptr_arith_range <= size_t(std::abs(move + int(imm - i - skip))) && emitPtrMove(i, program, j, move))
+				err = true;
+			move += int(imm - i - skip);
+			i = imm - 1;
+			break;
+		case '<':
+			for (imm = i + 1, skip = 0; imm < end; ++imm) {
+				if (is_nop(source[imm]))
+					++skip;
+				else
+				if ('<' != source[imm])
+					break;
+			}
+			if (Command32::ptr_arith_range <= size_t(std::abs(move - int(imm - i - skip))) && emitPtrMove(i, program, j, move))
+				err = true;
+			move -= int(imm - i - skip);
+			i = imm - 1;
+			break;
+		case ',':
+			if (emitAtPtrMove(OPCODE_INPUT, OPCODE_INPUT_AT, 0, i, program, j, move))
+				err = true;
+			break;
+		case '.':
+			if (emitAtPtrMove(OPCODE_OUTPUT, OPCODE_OUTPUT_AT, 0, i, program, j, move))
+				err = true;
+			break;
+		case '[':
+			if (emitPtrMove(i, program, j, move))
+				err = true;
+			imm = seekScanLoop(source, end, i, arith);
+			if (0 != imm) {
+				program[j++] = Command32(OPCODE_SCAN, 0);
+				program[j++] = Command32(OPCODE_SCAN, int8_t(arith), 0); // operand word
+				i = imm - 1;
+				break;
+			}
+			imm = seekSourceClose(source, end, i);
+			if (0 != imm)
+				imm = foldLoop(source, end, i, imm, program, j, err);
+			if (0 != imm) {
+				i = imm - 1;
+				break;
+			}
+			program[j++] = Command32(OPCODE_COND_L, 0); // defer offset calculation
+			break;
+		case ']':
+			if (emitPtrMove(i, program, j, move))
+				err = true;
+			program[j++] = Command32(OPCODE_COND_R, 0); // defer offset calculation
+			break;
+		}
+		++i;
+	}
+	if (emitPtrMove(i, program, j, move))
+		err = true;
+
+	return err;
+}
+
+static Command32* __attribute__ ((noinline)) translate(
+	const char* const source,
+	const size_t sourceLength,
+	Command32* const program,
+	size_t& programLength) {
+
+	size_t j = 0;
+	bool err = translateSpan(source, 0, sourceLength, program, j);
+
+	// calculate offsets
+	for (size_t i = 0; i < j; ++i)
+		if (program[i].hasOperand())
+			++i; // skip operand word
+		else
+		if (OPCODE_COND_L == program[i].getOp()) {
+			const size_t offset = seekBalancedClose(program + i, j - i);
+
+			if (0 == offset) {
+				stream::cerr << "program error: unmached [ at ip " << i << '\n';
+				err = true;
+				break;
+			}
+
+			if (Command32::branch_range > offset) {
+				program[i] = Command32(OPCODE_COND_L, uint32_t(offset));
+				program[i + offset] = Command32(OPCODE_COND_R, uint32_t(offset));
+				continue;
+			}
+
+			stream::cerr << "program error: way too far jump at ip " << i << '\n';
+			err = true;
+		}
+
+	if (err)
+		return 0;
+
+	programLength = j;
+	return program;
+}
+
+#if SPLIT_PROGRAM == 0
+// narrow a translated program to its compact form; return 0 if some immediate does not fit that
+static Command16* __attribute__ ((noinline)) narrow(
+	const Command32* const wide,
+	const size_t programLength,
+	Command16* const program) {
+
+	for (size_t i = 0; i < programLength; ++i) {
+		const Opcode op = wide[i].getOp();
+
+		if (wide[i].hasOperand()) {
+			program[i] = Command16(op, 0);
+			++i;
+			program[i] = Command16(op, wide[i].getDisp(), wide[i].getValue()); // operand word
+			continue;
+		}
+
+#if NIBBLE_OPCODE
+		if (Command16::imm_range <= wide[i].getImm())
+			return 0;
+
+		program[i] = Command16(op, uint16_t(wide[i].getImm()));
+
+#else
+		switch (op) {
+		case OPCODE_COND_L:
+		case OPCODE_COND_R:
+		case OPCODE_SET_WORD:
+			if (Command16::branch_range <= wide[i].getOffset())
+				return 0;
+
+			program[i] = Command16(op, uint16_t(wide[i].getOffset()));
+			break;
+		case OPCODE_ADD_WORD:
+		case OPCODE_ADD_PTR:
+		case OPCODE_SUB_PTR:
+			if (Command16::ptr_arith_range <= wide[i].getArith())
+				return 0;
+
+			program[i] = Command16(op, uint16_t(wide[i].getArith()));
+			break;
+		default:
+			program[i] = Command16(op, 0);
+		}
+
+#endif
+	}
+
+	return program;
+}
+
+#endif
+// print a word in ASCII or as a number, as the build and the command line have it
+static void print(
+	const word_t word,
+	const bool print_ascii) {
+
+#if PRINT_ASCII
+	(void) print_ascii;
+	stream::cout << char(word);
+
+#else
+	if (print_ascii)
+		stream::cout << char(word);
+	else
+		stream::cout << word << ' ';
+
+#endif
+}
+
+template < typename WORD_T, uintptr_t ALIGNMENT = cacheline_size >
+class AlignedPtr {
+	WORD_T* m;
+
+public:
+	AlignedPtr(const uintptr_t ptr)
+	: m(reinterpret_cast< WORD_T* >((ptr + ALIGNMENT - 1) & ~(ALIGNMENT - 1))) {
+	}
+
+	WORD_T* operator()() const {
+		return m;
+	}
+};
+
+template < typename WORD_T >
+class Ptr { // just for notational consistency with AlignedPtr
+	WORD_T* m;
+
+public:
+	Ptr(WORD_T* const ptr)
+	: m(ptr) {
+	}
+
+	WORD_T* operator()() const {
+		return m;
+	}
+};
+// decode a program into the ops of the backends, one per command word; return those, to be freed, or 0 on failure
+static backend::Op* decode(
+	const Command32* const program,
+	const size_t programLength) {
+
+	backend::Op* const op = reinterpret_cast< backend::Op* >(std::calloc(programLength + 1, sizeof(backend::Op)));
+
+	if (0 == op)
+		return 0;
+
+	// operand words stay NOP
+	for (size_t i = 0; i < programLength; ++i) {
+		const Command32 cmd = program[i];
+		backend::Op& o = op[i];
+
+#if NIBBLE_OPCODE
+		const size_t arith = cmd.getImm(); // either immediate is the one field
+		const size_t offset = cmd.getImm();
+
+#else
+		const size_t arith = cmd.getArith();
+		const size_t offset = cmd.getOffset();
+
+#endif
+		if (cmd.hasOperand()) {
+			o.disp = program[i + 1].getDisp();
+			o.value = program[i + 1].getValue();
+		}
+
+		switch (cmd.getOp()) {
+		case OPCODE_ADD_WORD:
+			o.kind = backend::ADD_WORD;
+			o.value = word_t(arith);
+			break;
+		case OPCODE_SET_WORD:
+			o.kind = backend::SET_WORD;
+			o.value = word_t(offset);
+			break;
+		case OPCODE_ADD_PTR:
+			o.kind = backend::MOVE_PTR;
+			o.delta = int32_t(arith);
+			break;
+		case OPCODE_SUB_PTR:
+			o.kind = backend::MOVE_PTR;
+			o.delta = -int32_t(arith);
+			break;
+		case OPCODE_COND_L:
+			o.kind = backend::COND_L;
+			o.delta = int32_t(offset);
+			break;
+		case OPCODE_COND_R:
+			o.kind = backend::COND_R;
+			o.delta = int32_t(offset);
+			break;
+		case OPCODE_INPUT:
+		case OPCODE_INPUT_AT:
+			o.kind = backend::INPUT;
+			break;
+		case OPCODE_OUTPUT:
+		case OPCODE_OUTPUT_AT:
+			o.kind = backend::OUTPUT;
+			break;
+		case OPCODE_MUL_ADD:
+			o.kind = backend::MUL_ADD;
+			break;
+		case OPCODE_SCAN:
+			o.kind = backend::SCAN;
+			o.delta = o.disp;
+			o.disp = 0;
+			break;
+		case OPCODE_ADD_WORD_AT:
+			o.kind = backend::ADD_WORD;
+			break;
+		}
+
+		if (cmd.hasOperand())
+			++i;
+	}
+
+	return op;
+}
+
+#if __x86_64__ && ENABLE_DIAGNOSTICS == 0
+// read a word off the input, on behalf of native code
+static word_t readWord() {
+	int input;
+	stream::cin >> input;
+	return word_t(input);
+}
+
+#endif
+#ifndef CODE_SPACE
+#define CODE_SPACE(length) ((length) * sizeof(Command32)) // either command form of the program
+
+#endif
+// run a translated program of the given length by the version, off space: CODE_SPACE of that for the program,
+// past a page boundary, then the tape, padded by fold_range words either side; defined by the version
+static int interpret(
+	const Command32* const wide,
+	const size_t programLength,
+	void* const space,
+	const size_t dataLength,
+	const cli_param& param);
+
+int main(
+	int argc,
+	char** argv) {
+
+	using testbed::scoped_ptr;
+	using testbed::get_buffer_from_file;
+
+	stream::cin.open(stdin);
+	stream::cout.open(stdout);
+	stream::cerr.open(stderr);
+
+	cli_param param;
+	param.memorySize = default_memory_size_kw << 10;
+	param.terminalCount = default_terminal_count;
+	param.flags = 0;
+	param.filename = 0;
+	param.output = 0;
+
+	const int result_cli = parse_cli(argc, argv, param);
+
+	if (0 != result_cli)
+		return result_cli;
+
+	const bool print_ascii = bool(param.flags & cli_param::FLAG_PRINT_ASCII);
+
+	size_t sourceLength = 0;
+	const scoped_ptr< char, generic_free > source(
+		reinterpret_cast< char* >(get_buffer_from_file(param.filename, sourceLength)));
+
+	if (0 == source()) {
+		stream::cerr << "failed to open source file\n";
+		return -1;
+	}
+
+	const size_t dataLength = param.memorySize;
+
+	const scoped_ptr< Command32, generic_free > ir(
+		reinterpret_cast< Command32* >(std::calloc(4 * sourceLength, sizeof(Command32))));
+
+	if (0 == ir()) {
+		stream::cerr << "failed to provide program memory\n";
+		return 0;
+	}
+
+	size_t programLength = 0;
+
+	const Ptr< Command32 > wide(
+		translate(source(), sourceLength, ir(), programLength));
+
+	if (!wide()) {
+		stream::cerr << "unable to provide program IR\n";
+		return -1;
+	}
+
+	// the backends which translate the program, rather than interpret it, take it decoded
+	const bool decoded = (param.flags & (cli_param::FLAG_EMIT_C | cli_param::FLAG_JIT)) || 0 != param.output;
+	const scoped_ptr< backend::Op, generic_free > ops(decoded ? decode(wide(), programLength) : 0);
+
+	if (decoded && 0 == ops()) {
+		stream::cerr << "unable to provide program IR\n";
+		return -1;
+	}
+
+	if (param.flags & cli_param::FLAG_EMIT_C) {
+		backend::emitC(stream::cout, ops(), programLength, dataLength, PRINT_ASCII || print_ascii, param.filename);
+		return 0;
+	}
+
+	if (0 != param.output) {
+
+#if __x86_64__
+		if (backend::writeStandalone(ops(), programLength, dataLength, PRINT_ASCII || print_ascii, param.output))
+			return 0;
+
+		stream::cerr << "failed to write standalone executable\n";
+
+#else
+		stream::cerr << "standalone executables unsupported by this build\n";
+
+#endif
+		return -1;
+	}
+
+	// program, then tape; closed-form loops may touch words up to fold_range either side of the tape even when they
+	// do not run, so pad it by that much
+	const scoped_ptr< void, generic_free > space(
+		std::calloc(CODE_SPACE(programLength) + (dataLength + 2 * fold_range) * sizeof(word_t) + mempage_size + 2 * cacheline_size, sizeof(int8_t)));
+
+	if (0 == space()) {
+		stream::cerr << "failed to provide program and data memory\n";
+		return 0;
+	}
+
+#if __x86_64__ && ENABLE_DIAGNOSTICS == 0
+	if (param.flags & cli_param::FLAG_JIT) {
+		const AlignedPtr< word_t, cacheline_size > mem(uintptr_t(space()) + fold_range * sizeof(word_t));
+
+		if (backend::runNative(ops(), programLength, mem(), dataLength, print_ascii, readWord, print))
+			return 0;
+
+		stream::cerr << "failed to compile program to native code; interpreting instead\n";
+	}
+
+#else
+	if (param.flags & cli_param::FLAG_JIT)
+		stream::cerr << "native code unsupported by this build; interpreting instead\n";
+
+#endif
+	return interpret(wide(), programLength, space(), dataLength, param);
+}
@@ -0,0 +1,453 @@
+#ifndef jit_H__
+#define jit_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#if __x86_64__
+#include <elf.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace jit {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Code emits x86-64 machine code for a byte tape into an anonymous mapping, which turns from
+// writable to executable upon finalize(). The emitted function takes the tape and its length as
+// args; the current word sits at rbx, the tape base at r12, its length at r13. Words at the current
+// one are addressed by an 8-bit displacement. Calls back into C++ happen on a 16-byte-aligned stack.
+// Alternatively, the code can be a series of loops, each emitted separately, which take the current
+// word as well, and return the current word upon exit; the code turns writable again to append one.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef void (*entry_t)(uint8_t* tape, size_t length);
+typedef uint8_t* (*loop_t)(uint8_t* word, uint8_t* tape, size_t length);
+typedef uint8_t (*input_t)();
+typedef void (*output_t)(uint8_t word, bool print_ascii);
+typedef size_t (*seek_t)(const uint8_t* tape, size_t length, size_t pos, size_t stride);
+
+#if __x86_64__
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Standalone code, as written out by writeElf, does without C++: it starts with the runtime below,
+// which keeps the output buffer at r13, its tail at r12, and the last int read at r14d, and does I/O
+// by raw syscalls. The current word sits at rbx, as above; scans get inlined.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static const uint8_t runtime[] = {
+	// put_num: eax = word; print it in decimal, followed by a space
+	0x83, 0xf8, 0x0a, // cmp eax,0xa
+	0x72, 0x2d, // jb rt+0x32
+	0x83, 0xf8, 0x64, // cmp eax,0x64
+	0x72, 0x14, // jb rt+0x1e
+	0xb9, 0x64, 0x00, 0x00, 0x00, // mov ecx,0x64
+	0x31, 0xd2, // xor edx,edx
+	0xf7, 0xf1, // div ecx
+	0x04, 0x30, // add al,0x30
+	0x41, 0x88, 0x04, 0x24, // mov byte ptr [r12],al
+	0x49, 0xff, 0xc4, // inc r12
+	0x89, 0xd0, // mov eax,edx
+	0xb9, 0x0a, 0x00, 0x00, 0x00, // mov ecx,0xa
+	0x31, 0xd2, // xor edx,edx
+	0xf7, 0xf1, // div ecx
+	0x04, 0x30, // add al,0x30
+	0x41, 0x88, 0x04, 0x24, // mov byte ptr [r12],al
+	0x49, 0xff, 0xc4, // inc r12
+	0x89, 0xd0, // mov eax,edx
+	0x04, 0x30, // add al,0x30
+	0x41, 0x88, 0x04, 0x24, // mov byte ptr [r12],al
+	0x41, 0xc6, 0x44, 0x24, 0x01, 0x20, // mov byte ptr [r12+0x1],0x20
+	0x49, 0x83, 0xc4, 0x02, // add r12,0x2
+	0xeb, 0x07, // jmp rt+0x4b
+	// put_char: al = char; print it
+	0x41, 0x88, 0x04, 0x24, // mov byte ptr [r12],al
+	0x49, 0xff, 0xc4, // inc r12
+	// check: flush if the output buffer is nearly full
+	0x4c, 0x89, 0xe0, // mov rax,r12
+	0x4c, 0x29, 0xe8, // sub rax,r13
+	0x48, 0x3d, 0xfc, 0xff, 0x00, 0x00, // cmp rax,0xfffc
+	0x77, 0x01, // ja rt+0x5a
+	0xc3, // ret
+	// flush: write out the output buffer at r13, up to r12
+	0x4c, 0x89, 0xee, // mov rsi,r13
+	0x4c, 0x89, 0xe2, // mov rdx,r12
+	0x48, 0x29, 0xf2, // sub rdx,rsi
+	0x74, 0x16, // je rt+0x7b
+	0xbf, 0x01, 0x00, 0x00, 0x00, // mov edi,0x1
+	0xb8, 0x01, 0x00, 0x00, 0x00, // mov eax,0x1
+	0x0f, 0x05, // syscall
+	0x48, 0x85, 0xc0, // test rax,rax
+	0x7e, 0x05, // jle rt+0x7b
+	0x48, 0x01, 0xc6, // add rsi,rax
+	0xeb, 0xe2, // jmp rt+0x5d
+	0x4d, 0x89, 0xec, // mov r12,r13
+	0xc3, // ret
+	// get: flush, then read a decimal int off stdin; eax = the int, or the last one read, r14d, if none
+	0xe8, 0xd6, 0xff, 0xff, 0xff, // call rt+0x5a
+	0x48, 0x83, 0xec, 0x08, // sub rsp,0x8
+	0x45, 0x31, 0xc0, // xor r8d,r8d
+	0x45, 0x31, 0xc9, // xor r9d,r9d
+	0x45, 0x31, 0xd2, // xor r10d,r10d
+	0xe8, 0x66, 0x00, 0x00, 0x00, // call rt+0xfc
+	0x83, 0xf8, 0xff, // cmp eax,0xffffffff
+	0x74, 0x45, // je rt+0xe0
+	0x83, 0xf8, 0x20, // cmp eax,0x20
+	0x74, 0xf1, // je rt+0x91
+	0x8d, 0x48, 0xf7, // lea ecx,[rax-0x9]
+	0x83, 0xf9, 0x04, // cmp ecx,0x4
+	0x76, 0xe9, // jbe rt+0x91
+	0x83, 0xf8, 0x2d, // cmp eax,0x2d
+	0x75, 0x0d, // jne rt+0xba
+	0x41, 0xb9, 0x01, 0x00, 0x00, 0x00, // mov r9d,0x1
+	0xe8, 0x44, 0x00, 0x00, 0x00, // call rt+0xfc
+	0xeb, 0x0a, // jmp rt+0xc4
+	0x83, 0xf8, 0x2b, // cmp eax,0x2b
+	0x75, 0x05, // jne rt+0xc4
+	0xe8, 0x38, 0x00, 0x00, 0x00, // call rt+0xfc
+	0x8d, 0x48, 0xd0, // lea ecx,[rax-0x30]
+	0x83, 0xf9, 0x09, // cmp ecx,0x9
+	0x77, 0x14, // ja rt+0xe0
+	0x45, 0x6b, 0xc0, 0x0a, // imul r8d,r8d,0xa
+	0x41, 0x01, 0xc8, // add r8d,ecx
+	0x41, 0xba, 0x01, 0x00, 0x00, 0x00, // mov r10d,0x1
+	0xe8, 0x1e, 0x00, 0x00, 0x00, // call rt+0xfc
+	0xeb, 0xe4, // jmp rt+0xc4
+	0x45, 0x85, 0xd2, // test r10d,r10d
+	0x74, 0x0f, // je rt+0xf4
+	0x44, 0x89, 0xc0, // mov eax,r8d
+	0xf7, 0xd8, // neg eax
+	0x45, 0x85, 0xc9, // test r9d,r9d
+	0x41, 0x0f, 0x44, 0xc0, // cmove eax,r8d
+	0x41, 0x89, 0xc6, // mov r14d,eax
+	0x44, 0x89, 0xf0, // mov eax,r14d
+	0x48, 0x83, 0xc4, 0x08, // add rsp,0x8
+	0xc3, // ret
+	// readc: eax = next char off stdin, or -1; the char lands in the caller's stack slot
+	0x31, 0xc0, // xor eax,eax
+	0x31, 0xff, // xor edi,edi
+	0x48, 0x8d, 0x74, 0x24, 0x08, // lea rsi,[rsp+0x8]
+	0xba, 0x01, 0x00, 0x00, 0x00, // mov edx,0x1
+	0x0f, 0x05, // syscall
+	0x48, 0x83, 0xf8, 0x01, // cmp rax,0x1
+	0x75, 0x06, // jne rt+0x118
+	0x0f, 0xb6, 0x44, 0x24, 0x08, // movzx eax,byte ptr [rsp+0x8]
+	0xc3, // ret
+	0xb8, 0xff, 0xff, 0xff, 0xff, // mov eax,0xffffffff
+	0xc3, // ret
+};
+
+enum {
+	runtime_put_num  = 0x00,
+	runtime_put_char = 0x44,
+	runtime_flush    = 0x5a,
+	runtime_get      = 0x7f,
+	runtime_out_size = 1 << 16
+};
+
+class Code {
+	uint8_t* buf;
+	size_t capacity;
+	size_t length;
+
+	Code(const Code&); // undefined
+	Code& operator =(const Code&); // undefined
+
+	void emit(const uint8_t b) {
+		buf[length++] = b;
+	}
+
+	void emit32(const uint32_t dw) {
+		memcpy(buf + length, &dw, sizeof(dw));
+		length += sizeof(dw);
+	}
+
+	void emit64(const uint64_t qw) {
+		memcpy(buf + length, &qw, sizeof(qw));
+		length += sizeof(qw);
+	}
+
+	// modrm for [rbx + disp8], with reg in the reg field
+	void emitAtWord(const uint8_t reg, const int8_t disp) {
+		emit(0x43 | reg << 3);
+		emit(uint8_t(disp));
+	}
+
+	// mov rax, fn; call rax
+	void emitCall(const uintptr_t fn) {
+		emit(0x48); emit(0xb8); emit64(fn);
+		emit(0xff); emit(0xd0);
+	}
+
+public:
+	// bytes of code a single command word translates to, at most
+	enum { max_command_size = 40 };
+	enum { max_frame_size = 64 };
+
+	explicit Code(const size_t a_capacity)
+	: buf(0)
+	, capacity(a_capacity)
+	, length(0) {
+		void* const p = mmap(0, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (MAP_FAILED != p)
+			buf = static_cast< uint8_t* >(p);
+	}
+
+	~Code() {
+		if (0 != buf)
+			munmap(buf, capacity);
+	}
+
+	bool valid() const {
+		return 0 != buf;
+	}
+
+	size_t size() const {
+		return length;
+	}
+
+	// bytes of code left to emit
+	size_t room() const {
+		return capacity - length;
+	}
+
+	const uint8_t* data() const {
+		return buf;
+	}
+
+	// push rbx; push r12; push r13; mov rbx, rdi; mov r12, rdi; mov r13, rsi
+	void prologue() {
+		emit(0x53);
+		emit(0x41); emit(0x54);
+		emit(0x41); emit(0x55);
+		emit(0x48); emit(0x89); emit(0xfb);
+		emit(0x49); emit(0x89); emit(0xfc);
+		emit(0x49); emit(0x89); emit(0xf5);
+	}
+
+	// pop r13; pop r12; pop rbx; ret
+	void epilogue() {
+		emit(0x41); emit(0x5d);
+		emit(0x41); emit(0x5c);
+		emit(0x5b);
+		emit(0xc3);
+	}
+
+	// loop entry: push rbx; push r12; push r13; mov rbx, rdi; mov r12, rsi; mov r13, rdx
+	void loopPrologue() {
+		emit(0x53);
+		emit(0x41); emit(0x54);
+		emit(0x41); emit(0x55);
+		emit(0x48); emit(0x89); emit(0xfb);
+		emit(0x49); emit(0x89); emit(0xf4);
+		emit(0x49); emit(0x89); emit(0xd5);
+	}
+
+	// loop exit: mov rax, rbx; pop r13; pop r12; pop rbx; ret
+	void loopEpilogue() {
+		emit(0x48); emit(0x89); emit(0xd8);
+		epilogue();
+	}
+
+	// add byte [rbx + disp], imm
+	void addWord(const int8_t disp, const uint8_t imm) {
+		emit(0x80); emitAtWord(0, disp); emit(imm);
+	}
+
+	// mov byte [rbx + disp], imm
+	void setWord(const int8_t disp, const uint8_t imm) {
+		emit(0xc6); emitAtWord(0, disp); emit(imm);
+	}
+
+	// add rbx, delta
+	void movePtr(const int32_t delta) {
+		emit(0x48); emit(0x81); emit(0xc3); emit32(uint32_t(delta));
+	}
+
+	// movzx eax, byte [rbx]; imul eax, eax, factor; add byte [rbx + disp], al
+	void mulAdd(const int8_t disp, const uint8_t factor) {
+		emit(0x0f); emit(0xb6); emitAtWord(0, 0);
+		if (1 != factor) {
+			emit(0x69); emit(0xc0); emit32(factor);
+		}
+		emit(0x00); emitAtWord(0, disp);
+	}
+
+	// rbx = tape + fn(tape, length, rbx - tape, abs(stride)), fn being the forward or the reverse seek
+	void scan(const int8_t stride, const seek_t fwd, const seek_t rev) {
+		emit(0x4c); emit(0x89); emit(0xe7);
+		emit(0x4c); emit(0x89); emit(0xee);
+		emit(0x48); emit(0x89); emit(0xda);
+		emit(0x4c); emit(0x29); emit(0xe2);
+		emit(0xb9); emit32(uint32_t(0 < stride ? stride : -stride));
+		emitCall(reinterpret_cast< uintptr_t >(0 < stride ? fwd : rev));
+		emit(0x49); emit(0x8d); emit(0x1c); emit(0x04);
+	}
+
+	// byte [rbx + disp] = fn()
+	void input(const int8_t disp, const input_t fn) {
+		emitCall(reinterpret_cast< uintptr_t >(fn));
+		emit(0x88); emitAtWord(0, disp);
+	}
+
+	// fn(byte [rbx + disp], print_ascii)
+	void output(const int8_t disp, const bool print_ascii, const output_t fn) {
+		emit(0x0f); emit(0xb6); emitAtWord(7, disp);
+		emit(0xbe); emit32(print_ascii);
+		emitCall(reinterpret_cast< uintptr_t >(fn));
+	}
+
+	// cmp byte [rbx], 0; je <past the matching condR>; return the position past this, for condR
+	size_t condL() {
+		emit(0x80); emitAtWord(7, 0); emit(0);
+		emit(0x0f); emit(0x84); emit32(0); // patched by condR
+		return length;
+	}
+
+	// cmp byte [rbx], 0; jne <past the condL at pos>
+	void condR(const size_t pos) {
+		emit(0x80); emitAtWord(7, 0); emit(0);
+		emit(0x0f); emit(0x85); emit32(uint32_t(pos - (length + sizeof(uint32_t))));
+
+		const uint32_t rel = uint32_t(length - pos);
+		memcpy(buf + pos - sizeof(rel), &rel, sizeof(rel));
+	}
+
+	// emit the standalone runtime; return its position
+	size_t emitRuntime() {
+		const size_t pos = length;
+
+		memcpy(buf + length, runtime, sizeof(runtime));
+		length += sizeof(runtime);
+		return pos;
+	}
+
+	// standalone entry: mov rbx, tape; mov r13, out; mov r12, r13; xor r14d, r14d
+	void start(const uint64_t tape, const uint64_t out) {
+		emit(0x48); emit(0xbb); emit64(tape);
+		emit(0x49); emit(0xbd); emit64(out);
+		emit(0x4d); emit(0x89); emit(0xec);
+		emit(0x45); emit(0x31); emit(0xf6);
+	}
+
+	// standalone exit: call flush; mov eax, SYS_exit; xor edi, edi; syscall
+	void finish(const size_t rt) {
+		call(rt + runtime_flush);
+		emit(0xb8); emit32(60);
+		emit(0x31); emit(0xff);
+		emit(0x0f); emit(0x05);
+	}
+
+	// call rel32
+	void call(const size_t pos) {
+		emit(0xe8); emit32(uint32_t(pos - (length + sizeof(uint32_t))));
+	}
+
+	// loop: cmp byte [rbx], 0; je done; add rbx, stride; jmp loop; done:
+	void scanInline(const int8_t stride) {
+		const size_t loop = length;
+
+		emit(0x80); emitAtWord(7, 0); emit(0);
+		emit(0x74); emit(6);
+		emit(0x48); emit(0x83); emit(0xc3); emit(uint8_t(stride));
+		emit(0xeb); emit(uint8_t(loop - (length + 1)));
+	}
+
+	// standalone input: call get; mov byte [rbx + disp], al
+	void getWord(const int8_t disp, const size_t rt) {
+		call(rt + runtime_get);
+		emit(0x88); emitAtWord(0, disp);
+	}
+
+	// standalone output: movzx eax, byte [rbx + disp]; call put_char or put_num
+	void putWord(const int8_t disp, const bool print_ascii, const size_t rt) {
+		emit(0x0f); emit(0xb6); emitAtWord(0, disp);
+		call(rt + (print_ascii ? runtime_put_char : runtime_put_num));
+	}
+
+	// make the code executable; return its entry point, or 0 on failure
+	entry_t finalize() {
+		if (0 != mprotect(buf, capacity, PROT_READ | PROT_EXEC))
+			return 0;
+
+		return reinterpret_cast< entry_t >(buf);
+	}
+
+	// make the code executable; return the loop emitted at pos
+	loop_t finalizeLoop(const size_t pos) {
+		if (0 != mprotect(buf, capacity, PROT_READ | PROT_EXEC))
+			return 0;
+
+		return reinterpret_cast< loop_t >(buf + pos);
+	}
+
+	// make the code writable again, to append to it; return false on failure
+	bool reopen() {
+		return 0 == mprotect(buf, capacity, PROT_READ | PROT_WRITE);
+	}
+};
+
+// write a static executable of standalone code, starting at entry, with a zeroed .bss of bssSize at
+// bss; return false on failure
+static bool writeElf(
+	const char* const filename,
+	const Code& code,
+	const size_t entry,
+	const uint64_t bss,
+	const uint64_t bssSize) {
+
+	const uint64_t base = 0x400000;
+	const size_t headerSize = sizeof(Elf64_Ehdr) + 3 * sizeof(Elf64_Phdr);
+
+	Elf64_Ehdr ehdr;
+	memset(&ehdr, 0, sizeof(ehdr));
+	memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+	ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+	ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+	ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+	ehdr.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+	ehdr.e_type = ET_EXEC;
+	ehdr.e_machine = EM_X86_64;
+	ehdr.e_version = EV_CURRENT;
+	ehdr.e_entry = base + headerSize + entry;
+	ehdr.e_phoff = sizeof(Elf64_Ehdr);
+	ehdr.e_ehsize = sizeof(Elf64_Ehdr);
+	ehdr.e_phentsize = sizeof(Elf64_Phdr);
+	ehdr.e_phnum = 3;
+
+	// text, with the headers; bss; non-executable stack
+	Elf64_Phdr phdr[3];
+	memset(phdr, 0, sizeof(phdr));
+	phdr[0].p_type = PT_LOAD;
+	phdr[0].p_flags = PF_R | PF_X;
+	phdr[0].p_vaddr = base;
+	phdr[0].p_paddr = base;
+	phdr[0].p_filesz = headerSize + code.size();
+	phdr[0].p_memsz = headerSize + code.size();
+	phdr[0].p_align = 0x1000;
+	phdr[1].p_type = PT_LOAD;
+	phdr[1].p_flags = PF_R | PF_W;
+	phdr[1].p_vaddr = bss;
+	phdr[1].p_paddr = bss;
+	phdr[1].p_memsz = bssSize;
+	phdr[1].p_align = 0x1000;
+	phdr[2].p_type = PT_GNU_STACK;
+	phdr[2].p_flags = PF_R | PF_W;
+
+	FILE* const file = fopen(filename, "wb");
+
+	if (0 == file)
+		return false;
+
+	const bool success =
+		1 == fwrite(&ehdr, sizeof(ehdr), 1, file) &&
+		1 == fwrite(phdr, sizeof(phdr), 1, file) &&
+		1 == fwrite(code.data(), code.size(), 1, file);
+
+	return 0 == fclose(file) && success && 0 == chmod(filename, 0755);
+}
+
+#endif
+} // namespace jit
+
+#endif // jit_H__
@@ -3,9 +3,14 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
+#include <cmath>
+#include <time.h>
 #include "stream.hpp"
 #include "scoped.hpp"
 #include "util_file.hpp"
+#include "scan.hpp"
+#include "jit.hpp"
+#include "backend.hpp"
 
 // verify iostream-free status
 #if _GLIBCXX_IOSTREAM
@@ -23,6 +28,16 @@ static const char arg_prefix[]         = "-";
 static const char arg_memory_size[]    = "memory_size";
 static const char arg_terminal_count[] = "terminal_count";
 static const char arg_print_ascii[]    = "print_ascii";
+static const char arg_jit[]            = "jit";
+static const char arg_emit_c[]         = "emit-c";
+static const char arg_output[]         = "o";
+static const char arg_ngram_profile[]  = "ngram_profile";
+static const char arg_profile[]        = "profile";
+static const char arg_superinstructions[] = "superinstructions";
+static const char arg_quicken[]        = "quicken";
+static const char arg_tiered[]         = "tiered";
+static const char arg_show_engine[]    = "show_engine";
+static const char arg_repeat[]         = "repeat";
 
 static const size_t default_memory_size_kw = 32;
 static const size_t default_terminal_count = 4096;
@@ -37,14 +52,24 @@ static const size_t cacheline_size = 32;
 
 struct cli_param {
 	enum {
-		FLAG_PRINT_ASCII = 1
+		FLAG_PRINT_ASCII = 1,
+		FLAG_JIT         = 2,
+		FLAG_EMIT_C      = 4,
+		FLAG_QUICKEN     = 8,
+		FLAG_TIERED      = 16,
+		FLAG_SHOW_ENGINE = 32
 	};
 	uint64_t terminalCount;
 
 	uint32_t memorySize;
 	uint32_t flags;
+	uint32_t repeat;
 
 	const char* filename;
+	const char* output;
+	const char* ngramProfile;
+	const char* loopProfile;
+	const char* superinstructions;
 };
 
 static int __attribute__ ((noinline)) parse_cli(
@@ -73,6 +98,13 @@ static int __attribute__ ((noinline)) parse_cli(
 			continue;
 		}
 
+		if (!std::strcmp(argv[i] + prefix_len, arg_repeat)) {
+			if (++i == argc || 1 != sscanf(argv[i], "%u", &param.repeat) || 0 == param.repeat)
+				success = false;
+
+			continue;
+		}
+
 #if ENABLE_DIAGNOSTICS
 		if (!std::strcmp(argv[i] + prefix_len, arg_terminal_count)) {
 			if (++i == argc || 1 != sscanf(argv[i], "%lu", &param.terminalCount))
@@ -81,6 +113,24 @@ static int __attribute__ ((noinline)) parse_cli(
 			continue;
 		}
 
+		if (!std::strcmp(argv[i] + prefix_len, arg_ngram_profile)) {
+			if (++i == argc)
+				success = false;
+			else
+				param.ngramProfile = argv[i];
+
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_profile)) {
+			if (++i == argc)
+				success = false;
+			else
+				param.loopProfile = argv[i];
+
+			continue;
+		}
+
 #endif
 #if PRINT_ASCII == 0
 		if (!std::strcmp(argv[i] + prefix_len, arg_print_ascii)) {
@@ -89,6 +139,51 @@ static int __attribute__ ((noinline)) parse_cli(
 		}
 
 #endif
+#if QUICKEN == 0
+		if (!std::strcmp(argv[i] + prefix_len, arg_quicken)) {
+			param.flags |= size_t(cli_param::FLAG_QUICKEN);
+			continue;
+		}
+
+#endif
+		if (!std::strcmp(argv[i] + prefix_len, arg_jit)) {
+			param.flags |= size_t(cli_param::FLAG_JIT);
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_tiered)) {
+			param.flags |= size_t(cli_param::FLAG_TIERED);
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_show_engine)) {
+			param.flags |= size_t(cli_param::FLAG_SHOW_ENGINE);
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_emit_c)) {
+			param.flags |= size_t(cli_param::FLAG_EMIT_C);
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_output)) {
+			if (++i == argc)
+				success = false;
+			else
+				param.output = argv[i];
+
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_superinstructions)) {
+			if (++i == argc)
+				success = false;
+			else
+				param.superinstructions = argv[i];
+
+			continue;
+		}
+
 		success = false;
 	}
 
@@ -98,13 +193,26 @@ static int __attribute__ ((noinline)) parse_cli(
 			"\t" << arg_prefix << arg_memory_size << " <positive_integer>\t\t: amount of memory available to program, in words; default is " << default_memory_size_kw << "Kwords\n"
 
 #if ENABLE_DIAGNOSTICS
-			"\t" << arg_prefix << arg_terminal_count << " <positive_integer>\t: number of steps after which program is forcefully terminated; default is " << default_terminal_count << '\n'
+			"\t" << arg_prefix << arg_terminal_count << " <positive_integer>\t: number of steps after which program is forcefully terminated; default is " << default_terminal_count << "\n"
+			"\t" << arg_prefix << arg_ngram_profile << " <filename>\t\t: write the bigrams and trigrams of the dispatched ops to an n-gram profile\n"
+			"\t" << arg_prefix << arg_profile << " <filename>\t\t: write the execution counts, trip-count histograms and dispatch shares of the loops to a profile, by source position\n"
 
 #endif
 #if PRINT_ASCII == 0
 			"\t" << arg_prefix << arg_print_ascii << "\t\t\t\t: print in ASCII instead of numbers\n"
 
 #endif
+#if QUICKEN == 0
+			"\t" << arg_prefix << arg_quicken << "\t\t\t\t: interpret by specialising each op in place the first time it runs\n"
+
+#endif
+			"\t" << arg_prefix << arg_jit << "\t\t\t\t\t: compile program to native code, where supported; default is interpreting\n"
+			"\t" << arg_prefix << arg_tiered << "\t\t\t\t: interpret, compiling hot loops to native code, where supported\n"
+			"\t" << arg_prefix << arg_show_engine << "\t\t\t\t: print the target the interpreter loop got picked for\n"
+			"\t" << arg_prefix << arg_repeat << " <positive_integer>\t\t: run the translated program that many times, off a zeroed tape each, and print timing statistics as JSON; interpreter alone\n"
+			"\t" << arg_prefix << arg_emit_c << "\t\t\t\t: print program as a self-contained C translation unit instead of running it\n"
+			"\t" << arg_prefix << arg_output << " <filename>\t\t\t: write program as a standalone x86-64 executable instead of running it\n"
+			"\t" << arg_prefix << arg_superinstructions << " <filename>\t: interpret program with the hot op sequences of an n-gram profile fused into superinstructions\n"
 			;
 		return 1;
 	}
@@ -132,75 +240,125 @@ struct compile_assert< true > {
 };
 
 enum Opcode {
-	OPCODE_INC_WORD,          // '+'
-	OPCODE_DEC_WORD,          // '-'
 	OPCODE_INPUT,             // '.'
 	OPCODE_OUTPUT,            // ','
+	OPCODE_MUL_ADD,           // closed-form loop: word at displacement += word * factor, both from operand word
+	OPCODE_SCAN,              // '[>]' or '[<]', repetitions of either within: seek word 0 by stride from operand word
+	OPCODE_ADD_WORD_AT,       // as OPCODE_ADD_WORD, at displacement from operand word
+	OPCODE_INPUT_AT,          // as OPCODE_INPUT, at displacement from operand word
+	OPCODE_OUTPUT_AT,         // as OPCODE_OUTPUT, at displacement from operand word
+	OPCODE_FUSED,             // superinstruction: OPCODE_FUSED + its index in SUPERINSTRUCTIONS, followed by the words of its ops
+	OPCODE_SET_WORD = 0x4000, // '[-]' or '[+]', followed by repetitions of '+' and '-'
 	OPCODE_COND_L   = 0x8000, // '['
 	OPCODE_COND_R   = 0xc000, // ']'
+	OPCODE_ADD_WORD = 0x1000, // '+' and '-', repetitions of, mod word range
 	OPCODE_ADD_PTR  = 0x2000, // '>', repetitions of
 	OPCODE_SUB_PTR  = 0x3000, // '<', repetitions of
 };
 
+template < typename STORE_T >
 class Command {
-	uint16_t op; // encoding uses unsigned immediates (direction determined by the type of op)
+	STORE_T op; // encoding uses unsigned immediates (direction determined by the type of op)
+
+	// opcode classes sit at the top of the word, so shift them there from their 16-bit positions
+	enum { class_shift = 8 * (sizeof(STORE_T) - sizeof(uint16_t)) };
 
 	Command(); // undefined
 
 public:
-	enum { branch_range = 1 << 14 };
-	enum { ptr_arith_range = 1 << 12 };
+	enum { branch_range = 1 << (8 * sizeof(STORE_T) - 2) };
+	enum { ptr_arith_range = 1 << (8 * sizeof(STORE_T) - 4) };
 
 	Command(
 		const Opcode an_op,
-		const uint16_t an_imm) {
+		const STORE_T an_imm) {
 
 		switch (an_op) {
 		case OPCODE_COND_L:
 		case OPCODE_COND_R:
+		case OPCODE_ADD_WORD:
 		case OPCODE_ADD_PTR:
 		case OPCODE_SUB_PTR:
-			op = an_op | an_imm;
+		case OPCODE_SET_WORD:
+			op = STORE_T(an_op) << class_shift | an_imm;
 			break;
 		default:
 			op = an_op;
 		}
 	}
 
+	// operand word of a multi-word op
+	Command(
+		const Opcode,
+		const int8_t a_disp,
+		const word_t a_value)
+	: op(STORE_T(uint8_t(a_disp) << 8 | a_value)) {
+	}
+
 	Opcode getOp() const {
 
-		// is this a conditional branch?
-		if (op & uint16_t(0xc000))
-			return Opcode(op & uint16_t(0xc000));
+		// is this a conditional branch or word assignment?
+		if (op & STORE_T(0xc000) << class_shift)
+			return Opcode(op >> class_shift & 0xc000);
 
-		// is this ptr arithmetics?
-		if (op & uint16_t(0x3000))
-			return Opcode(op & uint16_t(0x3000));
+		// is this word or ptr arithmetics?
+		if (op & STORE_T(0x3000) << class_shift)
+			return Opcode(op >> class_shift & 0x3000);
 
 		return Opcode(op);
 	}
 
-	uint16_t getOffset() const {
-		return op & ~uint16_t(0xc000);
+	STORE_T getOffset() const {
+		return op & ~(STORE_T(0xc000) << class_shift);
+	}
+
+	STORE_T getArith() const {
+		return op & ~(STORE_T(0x3000) << class_shift);
+	}
+
+	// is this followed by an operand word?
+	bool hasOperand() const {
+		switch (getOp()) {
+		case OPCODE_MUL_ADD:
+		case OPCODE_SCAN:
+		case OPCODE_ADD_WORD_AT:
+		case OPCODE_INPUT_AT:
+		case OPCODE_OUTPUT_AT:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	int8_t getDisp() const {
+		return int8_t(op >> 8);
 	}
 
-	uint16_t getArith() const {
-		return op & ~uint16_t(0x3000);
+	word_t getValue() const {
+		return word_t(op);
 	}
 };
 
+typedef Command< uint16_t > Command16; // compact form, for programs whose immediates fit
+typedef Command< uint32_t > Command32; // wide form, for translation, and for programs that do not fit the compact one
+
 namespace {
-const compile_assert< 2 == sizeof(Command) > assert_sizeof_command;
+const compile_assert< 2 == sizeof(Command16) > assert_sizeof_command16;
+const compile_assert< 4 == sizeof(Command32) > assert_sizeof_command32;
 } // namespace annonymous
 
 static size_t seekBalancedClose(
-	const Command* const program,
+	const Command32* const program,
 	const size_t programLength) {
 
 	size_t count = 0;
 	size_t pos = 0;
 
 	while (++pos < programLength) {
+		if (program[pos].hasOperand()) {
+			++pos; // skip operand word
+			continue;
+		}
 		if (program[pos].getOp() == OPCODE_COND_L) {
 			++count;
 			continue;
@@ -227,83 +385,456 @@ static bool is_nop(const char op) {
 		op != '.';
 }
 
-static Command* __attribute__ ((noinline)) translate(
+// seek the end of a run of '+' and '-', starting at pos; return the run's net sum in arith
+static size_t seekArithRun(
+	const char* const source,
+	const size_t sourceLength,
+	size_t pos,
+	int& arith) {
+
+	for (arith = 0; pos < sourceLength; ++pos) {
+		if ('+' == source[pos])
+			++arith;
+		else
+		if ('-' == source[pos])
+			--arith;
+		else
+		if (!is_nop(source[pos]))
+			break;
+	}
+
+	return pos;
+}
+
+// seek the end of a scan loop, like '[>]' or '[<<<]', starting at its '['; return 0 if not such a loop
+static size_t seekScanLoop(
 	const char* const source,
 	const size_t sourceLength,
-	Command* const program,
-	size_t& programLength) {
+	size_t pos,
+	int& stride) {
+
+	for (stride = 0; ++pos < sourceLength; ) {
+		if ('>' == source[pos])
+			++stride;
+		else
+		if ('<' == source[pos])
+			--stride;
+		else
+		if (']' == source[pos])
+			return 0 != stride && int8_t(stride) == stride ? pos + 1 : 0;
+		else
+		if (!is_nop(source[pos]))
+			return 0;
+	}
 
-	size_t i = 0;
-	size_t j = 0;
+	return 0;
+}
+
+// seek the ']' matching the '[' at pos; return 0 if unmatched
+static size_t seekSourceClose(
+	const char* const source,
+	const size_t sourceLength,
+	size_t pos) {
+
+	size_t count = 0;
+
+	while (++pos < sourceLength) {
+		if ('[' == source[pos]) {
+			++count;
+			continue;
+		}
+		if (']' == source[pos]) {
+			if (0 == count)
+				return pos;
+			--count;
+		}
+	}
+
+	return 0;
+}
+
+// multiplicative inverse of an odd word, mod word range
+static word_t inverse(const word_t a) {
+	word_t x = a; // correct to 3 bits for any odd a; each newton step doubles that
+
+	x *= word_t(2 - a * x);
+	x *= word_t(2 - a * x);
+	return x;
+}
+
+enum { fold_range = 64 }; // farthest word from the counter a closed-form loop may touch
+enum { fold_span = 2 * fold_range + 1 };
+
+// affine form c + sum(coef[k] * w[k]) over the words w[] around a loop counter, as found at loop entry
+struct Affine {
+	word_t coef[fold_span];
+	word_t c;
+
+	void setVar(const size_t k) {
+		std::memset(coef, 0, sizeof(coef));
+		coef[k] = 1;
+		c = 0;
+	}
+
+	void setConst(const word_t a) {
+		std::memset(coef, 0, sizeof(coef));
+		c = a;
+	}
+
+	bool isConst() const {
+		for (size_t k = 0; k < fold_span; ++k)
+			if (0 != coef[k])
+				return false;
+
+		return true;
+	}
+
+	// is this the argument form stepped by a constant?
+	bool isStepOf(const Affine& a) const {
+		return 0 == std::memcmp(coef, a.coef, sizeof(coef));
+	}
+
+	void addScaled(const Affine& a, const word_t factor) {
+		for (size_t k = 0; k < fold_span; ++k)
+			coef[k] += word_t(a.coef[k] * factor);
+
+		c += word_t(a.c * factor);
+	}
+};
+
+// symbolically run the body (begin, end) of a loop whose counter sits at word[fold_range]; the body may
+// contain word arithmetics, pointer moves, and inner loops of those which step their counters by an odd
+// constant and leave the data pointer where they found it; return false if the body is not such
+static bool evalLoopBody(
+	const char* const source,
+	const size_t begin,
+	const size_t end,
+	Affine (& word)[fold_span],
+	const bool inner = false) {
+
+	size_t pos = fold_range;
+
+	for (size_t i = begin; i < end; ++i) {
+		switch (source[i]) {
+		case '+':
+			++word[pos].c;
+			break;
+		case '-':
+			--word[pos].c;
+			break;
+		case '>':
+			if (fold_span == ++pos)
+				return false;
+			break;
+		case '<':
+			if (0 == pos--)
+				return false;
+			break;
+		case '[': {
+				const size_t close = seekSourceClose(source, end, i);
+
+				if (inner || 0 == close)
+					return false;
+
+				// run the inner body on a blank slate, so it leaves behind its per-iteration deltas
+				Affine delta[fold_span];
+
+				for (size_t k = 0; k < fold_span; ++k)
+					delta[k].setConst(0);
+
+				if (!evalLoopBody(source, i + 1, close, delta, true))
+					return false;
+
+				const word_t step = delta[fold_range].c;
+
+				if (0 == (step & 1))
+					return false;
+
+				// n = counter * inverse(-step) iterations, each adding delta to the rest of the words
+				const word_t step_inv = inverse(word_t(-step));
+
+				for (size_t k = 0; k < fold_span; ++k) {
+					if (fold_range == k || 0 == delta[k].c)
+						continue;
+
+					const size_t at = pos + k - fold_range;
+
+					if (at >= fold_span)
+						return false;
+
+					word[at].addScaled(word[pos], word_t(delta[k].c * step_inv));
+				}
+
+				word[pos].setConst(0);
+				i = close;
+			}
+			break;
+		case ']':
+		case ',':
+		case '.':
+			return false;
+		}
+	}
+
+	return fold_range == pos;
+}
+
+static bool translateSpan(
+	const char* const source,
+	const size_t begin,
+	const size_t end,
+	Command32* const program,
+	size_t& j,
+	size_t* const origin = 0);
+
+// translate the loop spanning [begin, end] in closed form: the loop must leave the data pointer where it
+// found it, step its counter by an odd constant, and leave each other word either intact, or stepped by
+// a constant; words that get set to a constant are admitted by running the first iteration as-is, and
+// folding the rest; return the source position past the translation, or 0 if not possible
+static size_t foldLoop(
+	const char* const source,
+	const size_t sourceLength,
+	const size_t begin,
+	const size_t end,
+	Command32* const program,
+	size_t& j,
+	bool& err) {
+
+	Affine entry[fold_span];
+	Affine word[fold_span];
+
+	for (size_t k = 0; k < fold_span; ++k)
+		entry[k].setVar(k);
+
+	bool peel = false;
+
+	for (size_t pass = 0; true; ++pass) {
+		for (size_t k = 0; k < fold_span; ++k)
+			word[k] = entry[k];
+
+		if (!evalLoopBody(source, begin + 1, end, word))
+			return 0;
+
+		if (!word[fold_range].isStepOf(entry[fold_range]) || 0 == (word[fold_range].c & 1))
+			return 0;
+
+		size_t k = 0;
+
+		while (k < fold_span && word[k].isStepOf(entry[k]))
+			++k;
+
+		if (fold_span == k) {
+			peel = 0 != pass;
+			break;
+		}
+
+		if (0 != pass)
+			return 0;
+
+		// words that the first iteration sets to a constant enter the remaining iterations as such
+		for (k = 0; k < fold_span; ++k)
+			if (fold_range != k && word[k].isConst())
+				entry[k].setConst(word[k].c);
+	}
+
+	if (peel) {
+		program[j++] = Command32(OPCODE_COND_L, 0); // defer offset calculation
+
+		if (translateSpan(source, begin + 1, end, program, j))
+			err = true;
+	}
+
+	const word_t step_inv = inverse(word_t(entry[fold_range].c - word[fold_range].c));
+
+	for (size_t k = 0; k < fold_span; ++k) {
+		const word_t factor = word_t((word[k].c - entry[k].c) * step_inv);
+
+		if (fold_range == k || 0 == factor)
+			continue;
+
+		program[j++] = Command32(OPCODE_MUL_ADD, 0);
+		program[j++] = Command32(OPCODE_MUL_ADD, int8_t(k - fold_range), factor); // operand word
+	}
+
+	if (peel) {
+		program[j++] = Command32(OPCODE_SET_WORD, 0);
+		program[j++] = Command32(OPCODE_COND_R, 0); // defer offset calculation
+		return end + 1;
+	}
+
+	int arith;
+	const size_t pos = seekArithRun(source, sourceLength, end + 1, arith);
+
+	program[j++] = Command32(OPCODE_SET_WORD, word_t(arith));
+	return pos;
+}
+
+// emit the data-pointer move pending at source position pos; return true on error
+static bool emitPtrMove(
+	const size_t pos,
+	Command32* const program,
+	size_t& j,
+	int& move) {
+
+	const Opcode op = 0 > move ? OPCODE_SUB_PTR : OPCODE_ADD_PTR;
+	const size_t len = size_t(0 > move ? -move : move);
+	bool err = false;
+
+	if (0 == move)
+		return err;
+
+	if (Command32::ptr_arith_range > len) {
+		program[j++] = Command32(op, uint32_t(len));
+	}
+	else {
+		program[j++] = Command32(op, 0);
+		stream::cerr << "program error: way too many '" << (0 > move ? '<' : '>') << "' at ip " << pos << '\n';
+		err = true;
+	}
+
+	move = 0;
+	return err;
+}
+
+// emit op, or its displaced form op_at, at the data-pointer move pending at source position pos; return true on error
+static bool emitAtPtrMove(
+	const Opcode op,
+	const Opcode op_at,
+	const word_t value,
+	const size_t pos,
+	Command32* const program,
+	size_t& j,
+	int& move) {
+
+	if (0 != move && int8_t(move) == move) {
+		program[j++] = Command32(op_at, 0);
+		program[j++] = Command32(op_at, int8_t(move), value); // operand word
+		return false;
+	}
+
+	const bool err = emitPtrMove(pos, program, j, move);
+
+	program[j++] = Command32(op, value);
+	return err;
+}
+
+// translate the source span [begin, end) into program, starting at program[j]; unless origin is nil, record
+// there the source position of each command emitted, ie. that of the source op which flushed it; return true
+// on error
+static bool translateSpan(
+	const char* const source,
+	const size_t begin,
+	const size_t end,
+	Command32* const program,
+	size_t& j,
+	size_t* const origin) {
+
+	size_t i = begin;
 	bool err = false;
+	int move = 0; // data-pointer move pending since the last branch
 
-	while (i < sourceLength) {
+	while (i < end) {
+		const size_t at = i;
+		size_t first = j;
 		size_t imm;
 		size_t skip;
+		int arith;
 
 		switch (source[i]) {
 		case '+':
-			program[j++] = Command(OPCODE_INC_WORD, 0);
-			break;
 		case '-':
-			program[j++] = Command(OPCODE_DEC_WORD, 0);
+			imm = seekArithRun(source, end, i, arith);
+			if (0 != word_t(arith) && emitAtPtrMove(OPCODE_ADD_WORD, OPCODE_ADD_WORD_AT, word_t(arith), i, program, j, move))
+				err = true;
+			i = imm - 1;
 			break;
 		case '>':
-			for (imm = i + 1, skip = 0; imm < sourceLength; ++imm) {
+			for (imm = i + 1, skip = 0; imm < end; ++imm) {
 				if (is_nop(source[imm]))
 					++skip;
 				else
 				if ('>' != source[imm])
 					break;
 			}
-			if (Command::ptr_arith_range > imm - i - skip) {
-				program[j++] = Command(OPCODE_ADD_PTR, uint16_t(imm - i - skip));
-			}
-			else {
-				program[j++] = Command(OPCODE_ADD_PTR, 0);
-				stream::cerr << "program error: way too many '>' at ip " << i << '\n';
+			if (Command32::ptr_arith_range <= size_t(std::abs(move + int(imm - i - skip))) && emitPtrMove(i, program, j, move))
 				err = true;
-			}
+			move += int(imm - i - skip);
 			i = imm - 1;
 			break;
 		case '<':
-			for (imm = i + 1, skip = 0; imm < sourceLength; ++imm) {
+			for (imm = i + 1, skip = 0; imm < end; ++imm) {
 				if (is_nop(source[imm]))
 					++skip;
 				else
 				if ('<' != source[imm])
 					break;
 			}
-			if (Command::ptr_arith_range > imm - i - skip) {
-				program[j++] = Command(OPCODE_SUB_PTR, uint16_t(imm - i - skip));
-			}
-			else {
-				program[j++] = Command(OPCODE_SUB_PTR, 0);
-				stream::cerr << "program error: way too many '<' at ip " << i << '\n';
+			if (Command32::ptr_arith_range <= size_t(std::abs(move - int(imm - i - skip))) && emitPtrMove(i, program, j, move))
 				err = true;
-			}
+			move -= int(imm - i - skip);
 			i = imm - 1;
 			break;
 		case ',':
-			program[j++] = Command(OPCODE_INPUT, 0);
+			if (emitAtPtrMove(OPCODE_INPUT, OPCODE_INPUT_AT, 0, i, program, j, move))
+				err = true;
 			break;
 		case '.':
-			program[j++] = Command(OPCODE_OUTPUT, 0);
+			if (emitAtPtrMove(OPCODE_OUTPUT, OPCODE_OUTPUT_AT, 0, i, program, j, move))
+				err = true;
 			break;
 		case '[':
-			program[j++] = Command(OPCODE_COND_L, 0); // defer offset calculation
+			if (emitPtrMove(i, program, j, move))
+				err = true;
+			imm = seekScanLoop(source, end, i, arith);
+			if (0 != imm) {
+				program[j++] = Command32(OPCODE_SCAN, 0);
+				program[j++] = Command32(OPCODE_SCAN, int8_t(arith), 0); // operand word
+				i = imm - 1;
+				break;
+			}
+			imm = seekSourceClose(source, end, i);
+			if (0 != imm)
+				imm = foldLoop(source, end, i, imm, program, j, err);
+			if (0 != imm) {
+				i = imm - 1;
+				break;
+			}
+			program[j++] = Command32(OPCODE_COND_L, 0); // defer offset calculation
 			break;
 		case ']':
-			program[j++] = Command(OPCODE_COND_R, 0); // defer offset calculation
+			if (emitPtrMove(i, program, j, move))
+				err = true;
+			program[j++] = Command32(OPCODE_COND_R, 0); // defer offset calculation
 			break;
 		}
+		while (0 != origin && first < j)
+			origin[first++] = at;
 		++i;
 	}
+	const size_t first = j;
+
+	if (emitPtrMove(i, program, j, move))
+		err = true;
 
-	// calculate offsets
-	for (i = 0; i < j; ++i)
+	for (size_t k = first; 0 != origin && k < j; ++k)
+		origin[k] = end;
+
+	return err;
+}
+
+// calculate the offsets of the branches in program; return true on error
+static bool linkBranches(
+	Command32* const program,
+	const size_t programLength) {
+
+	bool err = false;
+
+	for (size_t i = 0; i < programLength; ++i)
+		if (program[i].hasOperand())
+			++i; // skip operand word
+		else
 		if (OPCODE_COND_L == program[i].getOp()) {
-			const size_t offset = seekBalancedClose(program + i, j - i);
+			const size_t offset = seekBalancedClose(program + i, programLength - i);
 
 			if (0 == offset) {
 				stream::cerr << "program error: unmached [ at ip " << i << '\n';
@@ -311,9 +842,9 @@ static Command* __attribute__ ((noinline)) translate(
 				break;
 			}
 
-			if (Command::branch_range > offset) {
-				program[i] = Command(OPCODE_COND_L, uint16_t(offset));
-				program[i + offset] = Command(OPCODE_COND_R, uint16_t(offset));
+			if (Command32::branch_range > offset) {
+				program[i] = Command32(OPCODE_COND_L, uint32_t(offset));
+				program[i + offset] = Command32(OPCODE_COND_R, uint32_t(offset));
 				continue;
 			}
 
@@ -321,6 +852,24 @@ static Command* __attribute__ ((noinline)) translate(
 			err = true;
 		}
 
+	return err;
+}
+
+// translate source into program; unless origin is nil, record there the source position of each command;
+// return 0 on error
+static Command32* __attribute__ ((noinline)) translate(
+	const char* const source,
+	const size_t sourceLength,
+	Command32* const program,
+	size_t& programLength,
+	size_t* const origin = 0) {
+
+	size_t j = 0;
+	bool err = translateSpan(source, 0, sourceLength, program, j, origin);
+
+	if (linkBranches(program, j))
+		err = true;
+
 	if (err)
 		return 0;
 
@@ -328,36 +877,1947 @@ static Command* __attribute__ ((noinline)) translate(
 	return program;
 }
 
-template < typename WORD_T, uintptr_t ALIGNMENT = cacheline_size >
-class AlignedPtr {
-	WORD_T* m;
+// narrow a translated program to its compact form; return 0 if some immediate does not fit that
+static Command16* __attribute__ ((noinline)) narrow(
+	const Command32* const wide,
+	const size_t programLength,
+	Command16* const program) {
 
-public:
-	AlignedPtr(const uintptr_t ptr)
-	: m(reinterpret_cast< WORD_T* >((ptr + ALIGNMENT - 1) & ~(ALIGNMENT - 1))) {
-	}
+	for (size_t i = 0; i < programLength; ++i) {
+		const Opcode op = wide[i].getOp();
 
-	WORD_T* operator()() const {
-		return m;
-	}
-};
+		if (wide[i].hasOperand()) {
+			program[i] = Command16(op, 0);
+			++i;
+			program[i] = Command16(op, wide[i].getDisp(), wide[i].getValue()); // operand word
+			continue;
+		}
 
-template < typename WORD_T >
-class Ptr { // just for notational consistency with AlignedPtr
-	WORD_T* m;
+		switch (op) {
+		case OPCODE_COND_L:
+		case OPCODE_COND_R:
+		case OPCODE_SET_WORD:
+			if (Command16::branch_range <= wide[i].getOffset())
+				return 0;
 
-public:
-	Ptr(WORD_T* const ptr)
-	: m(ptr) {
-	}
+			program[i] = Command16(op, uint16_t(wide[i].getOffset()));
+			break;
+		case OPCODE_ADD_WORD:
+		case OPCODE_ADD_PTR:
+		case OPCODE_SUB_PTR:
+			if (Command16::ptr_arith_range <= wide[i].getArith())
+				return 0;
 
-	WORD_T* operator()() const {
-		return m;
+			program[i] = Command16(op, uint16_t(wide[i].getArith()));
+			break;
+		default:
+			program[i] = Command16(op, 0);
+		}
 	}
-};
 
-int main(
-	int argc,
+	return program;
+}
+
+// superinstructions: sequences of two or three ops, the last of which alone may branch, which run off a single
+// dispatch; their handlers get generated from the handlers of their ops. The list holds the hottest n-grams of
+// the sample programs by their ops; which of these get used, and where, is up to the n-gram profile given to the
+// fusion pass
+#define SUPERINSTRUCTIONS(X2, X3)               \
+	X3( 0, ADD_PTR,     MUL_ADD,  SET_WORD)     \
+	X3( 1, MUL_ADD,     SET_WORD, SUB_PTR)      \
+	X3( 2, SET_WORD,    SUB_PTR,  COND_R)       \
+	X3( 3, SET_WORD,    ADD_PTR,  COND_R)       \
+	X3( 4, MUL_ADD,     SET_WORD, ADD_PTR)      \
+	X3( 5, SET_WORD,    SUB_PTR,  MUL_ADD)      \
+	X3( 6, MUL_ADD,     MUL_ADD,  SET_WORD)     \
+	X3( 7, SUB_PTR,     MUL_ADD,  MUL_ADD)      \
+	X3( 8, ADD_PTR,     SET_WORD, ADD_PTR)      \
+	X3( 9, ADD_WORD,    ADD_PTR,  MUL_ADD)      \
+	X3(10, SET_WORD,    ADD_PTR,  SET_WORD)     \
+	X3(11, SUB_PTR,     MUL_ADD,  SET_WORD)     \
+	X3(12, ADD_WORD_AT, ADD_PTR,  COND_R)       \
+	X3(13, ADD_WORD_AT, ADD_PTR,  COND_L)       \
+	X3(14, SET_WORD,    SUB_PTR,  COND_L)       \
+	X2(15, MUL_ADD,     SET_WORD)               \
+	X2(16, ADD_PTR,     MUL_ADD)                \
+	X2(17, SET_WORD,    SUB_PTR)                \
+	X2(18, SET_WORD,    ADD_PTR)                \
+	X2(19, SUB_PTR,     MUL_ADD)                \
+	X2(20, MUL_ADD,     MUL_ADD)                \
+	X2(21, ADD_PTR,     SET_WORD)               \
+	X2(22, ADD_WORD,    ADD_PTR)                \
+	X2(23, ADD_WORD_AT, ADD_PTR)                \
+	X2(24, ADD_WORD_AT, SUB_PTR)                \
+	X2(25, SET_WORD,    ADD_WORD_AT)            \
+	X2(26, ADD_PTR,     COND_R)                 \
+	X2(27, SUB_PTR,     COND_R)                 \
+	X2(28, ADD_PTR,     COND_L)                 \
+	X2(29, SUB_PTR,     COND_L)
+
+// an op with its immediates, as n-gram profiles have it; branches leave their offsets out
+struct Component {
+	uint32_t op;
+	uint32_t imm;
+	int32_t disp;
+	uint32_t value;
+};
+
+// the dispatched ops of a bigram or trigram, and the number of times those got dispatched in a row
+struct Ngram {
+	Component op[3];
+	uint32_t length;
+	uint64_t count;
+};
+
+// op names and immediates in n-gram profiles
+enum Args {
+	ARGS_NONE,      // no immediates
+	ARGS_IMM,       // immediate of the op word
+	ARGS_DISP,      // displacement from the operand word
+	ARGS_DISP_VALUE // displacement and value from the operand word
+};
+
+static const struct {
+	Opcode op;
+	Args args;
+	const char* name;
+} op_name[] = {
+	{ OPCODE_INPUT,       ARGS_NONE,       "INPUT" },
+	{ OPCODE_OUTPUT,      ARGS_NONE,       "OUTPUT" },
+	{ OPCODE_MUL_ADD,     ARGS_DISP_VALUE, "MUL_ADD" },
+	{ OPCODE_SCAN,        ARGS_DISP,       "SCAN" },
+	{ OPCODE_ADD_WORD_AT, ARGS_DISP_VALUE, "ADD_WORD_AT" },
+	{ OPCODE_INPUT_AT,    ARGS_DISP,       "INPUT_AT" },
+	{ OPCODE_OUTPUT_AT,   ARGS_DISP,       "OUTPUT_AT" },
+	{ OPCODE_SET_WORD,    ARGS_IMM,        "SET_WORD" },
+	{ OPCODE_COND_L,      ARGS_NONE,       "COND_L" },
+	{ OPCODE_COND_R,      ARGS_NONE,       "COND_R" },
+	{ OPCODE_ADD_WORD,    ARGS_IMM,        "ADD_WORD" },
+	{ OPCODE_ADD_PTR,     ARGS_IMM,        "ADD_PTR" },
+	{ OPCODE_SUB_PTR,     ARGS_IMM,        "SUB_PTR" }
+};
+
+static const size_t op_name_count = sizeof(op_name) / sizeof(op_name[0]);
+
+// the op at pos, with its immediates
+template < typename COMMAND_T >
+static Component getComponent(
+	const COMMAND_T* const program,
+	const size_t pos) {
+
+	const COMMAND_T cmd = program[pos];
+	Component comp = { uint32_t(cmd.getOp()), 0, 0, 0 };
+
+	if (cmd.hasOperand()) {
+		comp.disp = program[pos + 1].getDisp();
+		comp.value = program[pos + 1].getValue();
+	}
+	else
+	if (OPCODE_SET_WORD == cmd.getOp())
+		comp.imm = uint32_t(cmd.getOffset());
+	else
+	if (OPCODE_ADD_WORD == cmd.getOp() || OPCODE_ADD_PTR == cmd.getOp() || OPCODE_SUB_PTR == cmd.getOp())
+		comp.imm = uint32_t(cmd.getArith());
+
+	return comp;
+}
+
+static bool isSameComponent(
+	const Component& a,
+	const Component& b) {
+
+	return a.op == b.op && a.imm == b.imm && a.disp == b.disp && a.value == b.value;
+}
+
+// qsort order of n-grams by their ops
+static int cmpNgramOps(
+	const void* a,
+	const void* b) {
+
+	const Ngram& na = *reinterpret_cast< const Ngram* >(a);
+	const Ngram& nb = *reinterpret_cast< const Ngram* >(b);
+
+	if (na.length != nb.length)
+		return na.length < nb.length ? -1 : 1;
+
+	return std::memcmp(na.op, nb.op, sizeof(na.op));
+}
+
+// qsort order of n-grams by descending count
+static int cmpNgramCount(
+	const void* a,
+	const void* b) {
+
+	const Ngram& na = *reinterpret_cast< const Ngram* >(a);
+	const Ngram& nb = *reinterpret_cast< const Ngram* >(b);
+
+	if (na.count != nb.count)
+		return na.count > nb.count ? -1 : 1;
+
+	return cmpNgramOps(a, b);
+}
+
+// qsort order of n-grams by descending dispatches saved when fused
+static int cmpNgramGain(
+	const void* a,
+	const void* b) {
+
+	const Ngram& na = *reinterpret_cast< const Ngram* >(a);
+	const Ngram& nb = *reinterpret_cast< const Ngram* >(b);
+	const uint64_t ga = na.count * (na.length - 1);
+	const uint64_t gb = nb.count * (nb.length - 1);
+
+	if (ga != gb)
+		return ga > gb ? -1 : 1;
+
+	return cmpNgramOps(a, b);
+}
+
+// parse a decimal integer off [pos, end); return false if none
+static bool parseInt(
+	const char*& pos,
+	const char* const end,
+	int64_t& value) {
+
+	bool neg = false;
+
+	if (pos < end && '-' == *pos) {
+		neg = true;
+		++pos;
+	}
+
+	if (pos == end || '0' > *pos || '9' < *pos)
+		return false;
+
+	for (value = 0; pos < end && '0' <= *pos && '9' >= *pos; ++pos)
+		value = value * 10 + (*pos - '0');
+
+	if (neg)
+		value = -value;
+
+	return true;
+}
+
+// parse an n-gram off a profile line [pos, end); return false if malformed
+static bool parseNgram(
+	const char* pos,
+	const char* const end,
+	Ngram& ngram) {
+
+	int64_t count;
+
+	if (!parseInt(pos, end, count) || 0 > count)
+		return false;
+
+	std::memset(&ngram, 0, sizeof(ngram));
+	ngram.count = uint64_t(count);
+
+	while (pos < end && '\t' == *pos) {
+		if (3 == ngram.length)
+			return false;
+
+		const char* const name = ++pos;
+
+		while (pos < end && ' ' != *pos && '\t' != *pos)
+			++pos;
+
+		size_t k = 0;
+
+		while (k < op_name_count && (std::strlen(op_name[k].name) != size_t(pos - name) ||
+			std::strncmp(op_name[k].name, name, pos - name)))
+			++k;
+
+		if (op_name_count == k)
+			return false;
+
+		Component& comp = ngram.op[ngram.length++];
+		int64_t arg[2];
+		size_t argCount = 0;
+
+		while (pos < end && ' ' == *pos && argCount < 2)
+			if (!parseInt(++pos, end, arg[argCount++]))
+				return false;
+
+		comp.op = uint32_t(op_name[k].op);
+
+		switch (op_name[k].args) {
+		case ARGS_NONE:
+			if (0 != argCount)
+				return false;
+			break;
+		case ARGS_IMM:
+			if (1 != argCount || 0 > arg[0])
+				return false;
+			comp.imm = uint32_t(arg[0]);
+			break;
+		case ARGS_DISP:
+			if (1 != argCount || int8_t(arg[0]) != arg[0])
+				return false;
+			comp.disp = int32_t(arg[0]);
+			break;
+		case ARGS_DISP_VALUE:
+			if (2 != argCount || int8_t(arg[0]) != arg[0] || word_t(arg[1]) != arg[1])
+				return false;
+			comp.disp = int32_t(arg[0]);
+			comp.value = uint32_t(arg[1]);
+			break;
+		}
+	}
+
+	return pos == end && 2 <= ngram.length;
+}
+
+// print an n-gram as a profile line
+static void printNgram(
+	stream::out& out,
+	const Ngram& ngram) {
+
+	out << ngram.count;
+
+	for (size_t i = 0; i < ngram.length; ++i) {
+		const Component& comp = ngram.op[i];
+		size_t k = 0;
+
+		while (op_name[k].op != Opcode(comp.op))
+			++k;
+
+		out << '\t' << op_name[k].name;
+
+		switch (op_name[k].args) {
+		case ARGS_NONE:
+			break;
+		case ARGS_IMM:
+			out << ' ' << comp.imm;
+			break;
+		case ARGS_DISP:
+			out << ' ' << comp.disp;
+			break;
+		case ARGS_DISP_VALUE:
+			out << ' ' << comp.disp << ' ' << comp.value;
+			break;
+		}
+	}
+
+	out << '\n';
+}
+
+// position of the op dispatched after the op at pos, as that does or does not branch
+template < typename COMMAND_T >
+static size_t successor(
+	const COMMAND_T* const program,
+	const size_t pos,
+	const bool branched) {
+
+	const COMMAND_T cmd = program[pos];
+
+	if (!branched)
+		return pos + (cmd.hasOperand() ? 2 : 1);
+
+	if (OPCODE_COND_L == cmd.getOp())
+		return pos + size_t(cmd.getOffset()) + 1;
+
+	return pos - size_t(cmd.getOffset()) + 1;
+}
+
+// counts of the bigrams and trigrams of dispatched ops, by the position of their first op, and by whether that
+// and the op after it branched
+class NgramProfile {
+	uint64_t* bigram;  // [2 * pos + branched0]
+	uint64_t* trigram; // [4 * pos + 2 * branched0 + branched1]
+	size_t programLength;
+
+	size_t last[2];    // positions of the last two ops dispatched, oldest first
+	bool branched[2];  // did those branch?
+
+	NgramProfile(); // undefined
+	NgramProfile(const NgramProfile&); // undefined
+
+public:
+	NgramProfile(const size_t length)
+	: bigram(reinterpret_cast< uint64_t* >(std::calloc(2 * length, sizeof(uint64_t))))
+	, trigram(reinterpret_cast< uint64_t* >(std::calloc(4 * length, sizeof(uint64_t))))
+	, programLength(length) {
+		last[0] = last[1] = size_t(-1);
+		branched[0] = branched[1] = false;
+	}
+
+	~NgramProfile() {
+		std::free(bigram);
+		std::free(trigram);
+	}
+
+	bool valid() const {
+		return 0 != bigram && 0 != trigram;
+	}
+
+	// account for the op at pos, just dispatched
+	void record(
+		const size_t pos,
+		const bool taken) {
+
+		if (size_t(-1) != last[0])
+			++trigram[4 * last[0] + 2 * branched[0] + branched[1]];
+
+		if (size_t(-1) != last[1])
+			++bigram[2 * last[1] + branched[1]];
+
+		last[0] = last[1];
+		branched[0] = branched[1];
+		last[1] = pos;
+		branched[1] = taken;
+	}
+
+	// write out the n-grams of program, merged by their ops, hottest first; return false on error
+	template < typename COMMAND_T >
+	bool write(
+		const COMMAND_T* const program,
+		const char* const filename) const;
+};
+
+template < typename COMMAND_T >
+bool NgramProfile::write(
+	const COMMAND_T* const program,
+	const char* const filename) const {
+
+	using testbed::scoped_ptr;
+
+	const scoped_ptr< Ngram, generic_free > ngram(
+		reinterpret_cast< Ngram* >(std::calloc(6 * programLength + 1, sizeof(Ngram))));
+
+	if (0 == ngram())
+		return false;
+
+	size_t count = 0;
+
+	for (size_t pos = 0; pos < programLength; ++pos)
+		for (size_t i = 0; i < 6; ++i) {
+			const uint64_t n = 2 > i ? bigram[2 * pos + i] : trigram[4 * pos + i - 2];
+
+			if (0 == n)
+				continue;
+
+			Ngram& gram = ngram()[count++];
+			const size_t next = successor(program, pos, 2 > i ? bool(i) : bool((i - 2) & 2));
+
+			gram.op[0] = getComponent(program, pos);
+			gram.op[1] = getComponent(program, next);
+			gram.length = 2;
+			gram.count = n;
+
+			if (2 > i)
+				continue;
+
+			gram.op[2] = getComponent(program, successor(program, next, bool((i - 2) & 1)));
+			gram.length = 3;
+		}
+
+	// merge the n-grams of identical ops from different positions
+	std::qsort(ngram(), count, sizeof(Ngram), cmpNgramOps);
+
+	size_t merged = 0;
+
+	for (size_t i = 0; i < count; ++i)
+		if (0 != merged && 0 == cmpNgramOps(ngram() + merged - 1, ngram() + i))
+			ngram()[merged - 1].count += ngram()[i].count;
+		else
+			ngram()[merged++] = ngram()[i];
+
+	std::qsort(ngram(), merged, sizeof(Ngram), cmpNgramCount);
+
+	stream::out out;
+
+	if (!out.open(filename, false))
+		return false;
+
+	for (size_t i = 0; i < merged; ++i)
+		printNgram(out, ngram()[i]);
+
+	return out.is_good();
+}
+
+// trip-count buckets of the loop profile: none, one, then powers of two up to the last, which is open-ended
+enum { trip_buckets = 34 };
+
+// bucket of a trip count
+static size_t tripBucket(const uint64_t trips) {
+	size_t bucket = 0;
+
+	while (bucket + 1 < trip_buckets && (uint64_t(1) << bucket) <= trips)
+		++bucket;
+
+	return bucket;
+}
+
+// exact execution counts of the branches of a program, by position, from which those of its basic blocks follow,
+// as the branches delimit them; plus the trip-count histograms of its loops, by their ordinal
+class LoopProfile {
+	uint64_t* executed;  // [pos], of the branches
+	uint64_t* taken;     // [pos], of the branches
+	uint64_t* trips;     // [loop], of the iteration in progress
+	uint64_t* histogram; // [loop * trip_buckets + bucket]
+	size_t* loop;        // [pos], ordinal of the loop of the branch
+	size_t programLength;
+	size_t loopCount;
+
+	LoopProfile(); // undefined
+	LoopProfile(const LoopProfile&); // undefined
+
+public:
+	template < typename COMMAND_T >
+	LoopProfile(
+		const COMMAND_T* const program,
+		const size_t length);
+
+	~LoopProfile() {
+		std::free(executed);
+		std::free(taken);
+		std::free(trips);
+		std::free(histogram);
+		std::free(loop);
+	}
+
+	bool valid() const {
+		return 0 != executed && 0 != taken && 0 != trips && 0 != histogram && 0 != loop;
+	}
+
+	// account for the branch at pos, just dispatched; left tells a COND_L from a COND_R
+	void record(
+		const size_t pos,
+		const bool left,
+		const bool jumped) {
+
+		const size_t i = loop[pos];
+
+		++executed[pos];
+		taken[pos] += jumped;
+
+		if (left) {
+			if (jumped)
+				++histogram[i * trip_buckets];
+			else
+				trips[i] = 1;
+		}
+		else {
+			if (jumped)
+				++trips[i];
+			else
+				++histogram[i * trip_buckets + tripBucket(trips[i])];
+		}
+	}
+
+	// write out the loops of program, hottest first, by their source positions per origin; return false on error
+	template < typename COMMAND_T >
+	bool write(
+		const COMMAND_T* const program,
+		const size_t* const origin,
+		const char* const source,
+		const size_t sourceLength,
+		const char* const filename) const;
+};
+
+template < typename COMMAND_T >
+LoopProfile::LoopProfile(
+	const COMMAND_T* const program,
+	const size_t length)
+: executed(reinterpret_cast< uint64_t* >(std::calloc(length + 1, sizeof(uint64_t))))
+, taken(reinterpret_cast< uint64_t* >(std::calloc(length + 1, sizeof(uint64_t))))
+, trips(0)
+, histogram(0)
+, loop(reinterpret_cast< size_t* >(std::calloc(length + 1, sizeof(size_t))))
+, programLength(length)
+, loopCount(0) {
+
+	if (0 == loop)
+		return;
+
+	for (size_t pos = 0; pos < programLength; pos += program[pos].hasOperand() ? 2 : 1)
+		if (OPCODE_COND_L == program[pos].getOp()) {
+			loop[pos] = loopCount;
+			loop[pos + program[pos].getOffset()] = loopCount;
+			++loopCount;
+		}
+
+	trips = reinterpret_cast< uint64_t* >(std::calloc(loopCount + 1, sizeof(uint64_t)));
+	histogram = reinterpret_cast< uint64_t* >(std::calloc((loopCount + 1) * trip_buckets, sizeof(uint64_t)));
+}
+
+// a loop of the profile, by its dispatches
+struct LoopShare {
+	size_t pos;
+	size_t line;
+	size_t column;
+	uint64_t dispatches;
+};
+
+// order of loops by dispatches, descending, then by position, for qsort
+static int cmpLoopShare(
+	const void* a,
+	const void* b) {
+
+	const LoopShare& la = *reinterpret_cast< const LoopShare* >(a);
+	const LoopShare& lb = *reinterpret_cast< const LoopShare* >(b);
+
+	if (la.dispatches != lb.dispatches)
+		return la.dispatches > lb.dispatches ? -1 : 1;
+
+	return la.pos < lb.pos ? -1 : la.pos > lb.pos ? 1 : 0;
+}
+
+template < typename COMMAND_T >
+bool LoopProfile::write(
+	const COMMAND_T* const program,
+	const size_t* const origin,
+	const char* const source,
+	const size_t sourceLength,
+	const char* const filename) const {
+
+	using testbed::scoped_ptr;
+
+	const scoped_ptr< LoopShare, generic_free > share(
+		reinterpret_cast< LoopShare* >(std::calloc(loopCount + 1, sizeof(LoopShare))));
+
+	if (0 == share())
+		return false;
+
+	// a basic block gets entered by the fall-through or the jump of the branch ending the preceding block, or by
+	// the jump of the branch at the other end of the loop; each of its ops gets dispatched as many times. The
+	// dispatches of a loop, its own branches and nested loops included, are those between its branches
+	uint64_t entries = 0 != programLength;
+	uint64_t total = 0;
+
+	// lines and columns count from one, as per editors
+	size_t line = 1;
+	size_t column = 1;
+	size_t cursor = 0;
+
+	for (size_t pos = 0; pos < programLength; pos += program[pos].hasOperand() ? 2 : 1) {
+		const Opcode op = program[pos].getOp();
+
+		if (OPCODE_COND_L != op && OPCODE_COND_R != op) {
+			total += entries;
+			continue;
+		}
+
+		LoopShare& share_i = share()[loop[pos]];
+
+		if (OPCODE_COND_L == op) {
+			for (; cursor < origin[pos] && cursor < sourceLength; ++cursor)
+				if ('\n' == source[cursor]) {
+					++line;
+					column = 1;
+				}
+				else
+					++column;
+
+			share_i.pos = pos;
+			share_i.line = line;
+			share_i.column = column;
+			share_i.dispatches = total;
+
+			total += executed[pos];
+			entries = executed[pos] - taken[pos] + taken[pos + program[pos].getOffset()];
+			continue;
+		}
+
+		total += executed[pos];
+		entries = executed[pos] - taken[pos] + taken[pos - program[pos].getOffset()];
+		share_i.dispatches = total - share_i.dispatches;
+	}
+
+	std::qsort(share(), loopCount, sizeof(LoopShare), cmpLoopShare);
+
+	stream::out out;
+
+	if (!out.open(filename, false))
+		return false;
+
+	out << "# loops: " << uint64_t(loopCount) << ", dispatches: " << total << "\n"
+		"# offset\tline:column\tentries\titerations\tdispatches\tshare\ttrips: count\n";
+
+	for (size_t i = 0; i < loopCount; ++i) {
+		const LoopShare& share_i = share()[i];
+		const size_t pos = share_i.pos;
+		const size_t index = loop[pos];
+
+		char percent[16];
+		std::snprintf(percent, sizeof(percent), "%.2f%%", 0 != total ? 100. * share_i.dispatches / total : 0.);
+
+		out << uint64_t(origin[pos]) << '\t' << uint64_t(share_i.line) << ':' << uint64_t(share_i.column) << '\t' <<
+			executed[pos] << '\t' << executed[pos] - taken[pos] + taken[pos + program[pos].getOffset()] << '\t' <<
+			share_i.dispatches << '\t' << percent;
+
+		for (size_t b = 0; b < trip_buckets; ++b) {
+			const uint64_t n = histogram[index * trip_buckets + b];
+
+			if (0 == n)
+				continue;
+
+			// bucket b > 0 holds [2^(b - 1), 2^b) trips, the last one open-ended
+			const uint64_t low = 0 == b ? 0 : uint64_t(1) << (b - 1);
+			const uint64_t high = 2 > b ? low : (uint64_t(1) << b) - 1;
+
+			out << '\t' << low;
+
+			if (trip_buckets == b + 1)
+				out << '+';
+			else
+			if (low != high)
+				out << '-' << high;
+
+			out << ": " << n;
+		}
+
+		out << '\n';
+	}
+
+	return out.is_good();
+}
+
+// ops of a superinstruction
+struct Shape {
+	uint32_t length;
+	Opcode op[3];
+};
+
+#define SHAPE2(index, op0, op1) { 2, { OPCODE_##op0, OPCODE_##op1, OPCODE_FUSED } },
+#define SHAPE3(index, op0, op1, op2) { 3, { OPCODE_##op0, OPCODE_##op1, OPCODE_##op2 } },
+
+static const Shape superinstruction[] = {
+	SUPERINSTRUCTIONS(SHAPE2, SHAPE3)
+};
+
+#undef SHAPE2
+#undef SHAPE3
+
+static const size_t superinstruction_count = sizeof(superinstruction) / sizeof(superinstruction[0]);
+
+namespace {
+const compile_assert< OPCODE_FUSED + superinstruction_count <= OPCODE_ADD_WORD > assert_superinstruction_count;
+} // namespace annonymous
+
+// index of the superinstruction of the ops of an n-gram; superinstruction_count if none
+static size_t findShape(const Ngram& ngram) {
+	for (size_t s = 0; s < superinstruction_count; ++s) {
+		size_t i = 0;
+
+		while (i < ngram.length && superinstruction[s].length == ngram.length && superinstruction[s].op[i] == Opcode(ngram.op[i].op))
+			++i;
+
+		if (ngram.length == i)
+			return s;
+	}
+
+	return superinstruction_count;
+}
+
+// fuse the sequences of ops of program which match the hot n-grams of a profile, as written by a diagnostics
+// build, into superinstructions at fused, which takes up to 3/2 the length of program; return 0 on error
+static Command32* __attribute__ ((noinline)) fuse(
+	const Command32* const program,
+	const size_t programLength,
+	const char* const filename,
+	Command32* const fused,
+	size_t& fusedLength) {
+
+	using testbed::scoped_ptr;
+	using testbed::get_buffer_from_file;
+
+	size_t length = 0;
+	const scoped_ptr< char, generic_free > profile(get_buffer_from_file(filename, length));
+
+	if (0 == profile())
+		return 0;
+
+	size_t lineCount = 0;
+
+	for (size_t i = 0; i < length; ++i)
+		if ('\n' == profile()[i])
+			++lineCount;
+
+	const scoped_ptr< Ngram, generic_free > ngram(
+		reinterpret_cast< Ngram* >(std::calloc(lineCount + 1, sizeof(Ngram))));
+	const scoped_ptr< size_t, generic_free > start(
+		reinterpret_cast< size_t* >(std::calloc(programLength + 1, sizeof(size_t))));
+	const scoped_ptr< size_t, generic_free > group(
+		reinterpret_cast< size_t* >(std::calloc(programLength + 1, sizeof(size_t))));
+
+	if (0 == fused || 0 == ngram() || 0 == start() || 0 == group())
+		return 0;
+
+	size_t count = 0;
+
+	for (const char* line = profile(); line < profile() + length; ++count) {
+		const char* const end = reinterpret_cast< const char* >(std::memchr(line, '\n', profile() + length - line));
+
+		if (0 == end || !parseNgram(line, end, ngram()[count])) {
+			stream::cerr << "malformed n-gram profile at line " << count + 1 << '\n';
+			return 0;
+		}
+
+		line = end + 1;
+	}
+
+	std::qsort(ngram(), count, sizeof(Ngram), cmpNgramGain);
+
+	// positions of the ops
+	size_t opCount = 0;
+
+	for (size_t i = 0; i < programLength; ++i) {
+		start()[opCount++] = i;
+
+		if (program[i].hasOperand())
+			++i; // skip operand word
+	}
+
+	// claim the runs of ops matching the n-grams, most dispatches saved first: group holds 0 for an op left as is, 1 for an op
+	// within a superinstruction, and 2 plus the superinstruction index for the first op of one
+	for (size_t n = 0; n < count; ++n) {
+		const size_t s = findShape(ngram()[n]);
+
+		if (superinstruction_count == s)
+			continue;
+
+		for (size_t k = 0; k + ngram()[n].length <= opCount; ++k) {
+			size_t i = 0;
+
+			while (i < ngram()[n].length && 0 == group()[k + i] && isSameComponent(ngram()[n].op[i], getComponent(program, start()[k + i])))
+				++i;
+
+			if (ngram()[n].length != i)
+				continue;
+
+			group()[k] = 2 + s;
+
+			for (i = 1; i < ngram()[n].length; ++i)
+				group()[k + i] = 1;
+
+			k += ngram()[n].length - 1;
+		}
+	}
+
+	size_t j = 0;
+
+	for (size_t k = 0; k < opCount; ++k) {
+		if (1 < group()[k])
+			fused[j++] = Command32(Opcode(OPCODE_FUSED + group()[k] - 2), 0);
+
+		fused[j++] = program[start()[k]];
+
+		if (program[start()[k]].hasOperand())
+			fused[j++] = program[start()[k] + 1]; // operand word
+	}
+
+	if (linkBranches(fused, j))
+		return 0;
+
+	fusedLength = j;
+	return fused;
+}
+
+// print a word in ASCII or as a number, as the build and the command line have it
+static void print(
+	const word_t word,
+	const bool print_ascii) {
+
+#if PRINT_ASCII
+	(void) print_ascii;
+	stream::cout << char(word);
+
+#else
+	if (print_ascii)
+		stream::cout << char(word);
+	else
+		stream::cout << word << ' ';
+
+#endif
+}
+
+template < typename WORD_T, uintptr_t ALIGNMENT = cacheline_size >
+class AlignedPtr {
+	WORD_T* m;
+
+public:
+	AlignedPtr(const uintptr_t ptr)
+	: m(reinterpret_cast< WORD_T* >((ptr + ALIGNMENT - 1) & ~(ALIGNMENT - 1))) {
+	}
+
+	WORD_T* operator()() const {
+		return m;
+	}
+};
+
+template < typename WORD_T >
+class Ptr { // just for notational consistency with AlignedPtr
+	WORD_T* m;
+
+public:
+	Ptr(WORD_T* const ptr)
+	: m(ptr) {
+	}
+
+	WORD_T* operator()() const {
+		return m;
+	}
+};
+
+// decode a program into the ops of the backends, one per command word; return those, to be freed, or 0 on failure
+static backend::Op* decode(
+	const Command32* const program,
+	const size_t programLength) {
+
+	backend::Op* const op = reinterpret_cast< backend::Op* >(std::calloc(programLength + 1, sizeof(backend::Op)));
+
+	if (0 == op)
+		return 0;
+
+	// operand words stay NOP
+	for (size_t i = 0; i < programLength; ++i) {
+		const Command32 cmd = program[i];
+		backend::Op& o = op[i];
+
+		if (cmd.hasOperand()) {
+			o.disp = program[i + 1].getDisp();
+			o.value = program[i + 1].getValue();
+		}
+
+		switch (cmd.getOp()) {
+		case OPCODE_ADD_WORD:
+			o.kind = backend::ADD_WORD;
+			o.value = word_t(cmd.getArith());
+			break;
+		case OPCODE_SET_WORD:
+			o.kind = backend::SET_WORD;
+			o.value = word_t(cmd.getOffset());
+			break;
+		case OPCODE_ADD_PTR:
+			o.kind = backend::MOVE_PTR;
+			o.delta = int32_t(cmd.getArith());
+			break;
+		case OPCODE_SUB_PTR:
+			o.kind = backend::MOVE_PTR;
+			o.delta = -int32_t(cmd.getArith());
+			break;
+		case OPCODE_COND_L:
+			o.kind = backend::COND_L;
+			o.delta = int32_t(cmd.getOffset());
+			break;
+		case OPCODE_COND_R:
+			o.kind = backend::COND_R;
+			o.delta = int32_t(cmd.getOffset());
+			break;
+		case OPCODE_INPUT:
+		case OPCODE_INPUT_AT:
+			o.kind = backend::INPUT;
+			break;
+		case OPCODE_OUTPUT:
+		case OPCODE_OUTPUT_AT:
+			o.kind = backend::OUTPUT;
+			break;
+		case OPCODE_MUL_ADD:
+			o.kind = backend::MUL_ADD;
+			break;
+		case OPCODE_SCAN:
+			o.kind = backend::SCAN;
+			o.delta = o.disp;
+			o.disp = 0;
+			break;
+		case OPCODE_ADD_WORD_AT:
+			o.kind = backend::ADD_WORD;
+			break;
+		default: // superinstruction headers, OPCODE_FUSED + their index, are for the interpreter alone; their ops follow
+			assert(OPCODE_FUSED <= cmd.getOp() && cmd.getOp() < OPCODE_FUSED + superinstruction_count);
+			break;
+		}
+
+		if (cmd.hasOperand())
+			++i;
+	}
+
+	return op;
+}
+
+#if __x86_64__ && ENABLE_DIAGNOSTICS == 0
+// upper tier of the interpreter: a loop whose header gets reached often enough, on entry or on iteration, gets
+// compiled to native code, which takes over the loop from its header and returns at its exit
+class Tier {
+	jit::Code code;
+	backend::Op* program; // decoded for the backend
+	size_t programLength;
+	size_t dataLength;
+	bool print_ascii;
+
+	uint32_t* heat;      // times reached, by position of the loop's COND_L
+	jit::loop_t* native; // native code, by position of the loop's COND_L
+	size_t* loop;        // code positions of the branches, by their program positions
+
+	Tier(const Tier&); // undefined
+	Tier& operator =(const Tier&); // undefined
+
+	bool compile(const size_t pos);
+
+public:
+	enum { threshold = 1 << 10 };
+	static const size_t cold = size_t(-1);
+
+	Tier(
+		const Command32* const a_program,
+		const size_t a_programLength,
+		const size_t a_dataLength,
+		const bool a_print_ascii)
+	: code(4 * (a_programLength * jit::Code::max_command_size + jit::Code::max_frame_size))
+	, program(decode(a_program, a_programLength))
+	, programLength(a_programLength)
+	, dataLength(a_dataLength)
+	, print_ascii(a_print_ascii)
+	, heat(reinterpret_cast< uint32_t* >(std::calloc(a_programLength + 1, sizeof(uint32_t))))
+	, native(reinterpret_cast< jit::loop_t* >(std::calloc(a_programLength + 1, sizeof(jit::loop_t))))
+	, loop(reinterpret_cast< size_t* >(std::calloc(a_programLength + 1, sizeof(size_t)))) {
+	}
+
+	~Tier() {
+		std::free(program);
+		std::free(heat);
+		std::free(native);
+		std::free(loop);
+	}
+
+	bool valid() const {
+		return code.valid() && 0 != program && 0 != heat && 0 != native && 0 != loop;
+	}
+
+	// reach the header of the loop of the COND_L at pos, with the word at dp non-zero; if the loop is hot, run it
+	// natively to its exit and return the data pointer there, otherwise return cold for the interpreter to run it
+	size_t enter(
+		const size_t pos,
+		word_t* const mem,
+		const size_t dp) {
+
+		if (0 == native[pos] && (threshold > ++heat[pos] || !compile(pos)))
+			return cold;
+
+		return size_t(native[pos](mem + dp, mem, dataLength) - mem);
+	}
+};
+
+#else
+class Tier;
+
+#endif
+// state of a running program, as the op handlers see it; only a tiered one hands hot loops over to its tier
+template < typename COMMAND_T, bool TIERED >
+struct Machine {
+	const COMMAND_T* program;
+	word_t* mem;
+	size_t dataLength;
+	size_t ip;
+	size_t dp;
+	bool print_ascii;
+	Tier* tier; // upper tier, if any
+};
+
+// is the data pointer still in bounds? always, as far as non-diagnostics builds know
+template < typename COMMAND_T, bool TIERED >
+static bool inBounds(const Machine< COMMAND_T, TIERED >& m) {
+
+#if ENABLE_DIAGNOSTICS
+	return m.dp < m.dataLength;
+
+#else
+	(void) m;
+	return true;
+
+#endif
+}
+
+// op handlers: run the op at ip, leaving ip at its last word, or at the op before a branch target
+template < Opcode OP >
+struct Handler;
+
+template <>
+struct Handler< OPCODE_ADD_WORD > {
+	template < typename COMMAND_T, bool TIERED >
+	static void __attribute__ ((always_inline)) exec(Machine< COMMAND_T, TIERED >& m) {
+		m.mem[m.dp] += word_t(m.program[m.ip].getArith());
+	}
+};
+
+template <>
+struct Handler< OPCODE_SET_WORD > {
+	template < typename COMMAND_T, bool TIERED >
+	static void __attribute__ ((always_inline)) exec(Machine< COMMAND_T, TIERED >& m) {
+		m.mem[m.dp] = word_t(m.program[m.ip].getOffset());
+	}
+};
+
+template <>
+struct Handler< OPCODE_MUL_ADD > {
+	template < typename COMMAND_T, bool TIERED >
+	static void __attribute__ ((always_inline)) exec(Machine< COMMAND_T, TIERED >& m) {
+
+#if ENABLE_DIAGNOSTICS
+		if (0 != m.mem[m.dp] && m.dp + m.program[m.ip + 1].getDisp() >= m.dataLength) {
+			m.dp += m.program[m.ip + 1].getDisp();
+			return;
+		}
+
+#endif
+		++m.ip;
+		m.mem[m.dp + m.program[m.ip].getDisp()] += m.mem[m.dp] * m.program[m.ip].getValue();
+	}
+};
+
+template <>
+struct Handler< OPCODE_SCAN > {
+	template < typename COMMAND_T, bool TIERED >
+	static void __attribute__ ((always_inline)) exec(Machine< COMMAND_T, TIERED >& m) {
+		++m.ip;
+		if (0 < m.program[m.ip].getDisp())
+			m.dp = scan::seek_zero_fwd(m.mem, m.dataLength, m.dp, size_t(m.program[m.ip].getDisp()));
+		else
+			m.dp = scan::seek_zero_rev(m.mem, m.dataLength, m.dp, size_t(-m.program[m.ip].getDisp()));
+	}
+};
+
+template <>
+struct Handler< OPCODE_INPUT > {
+	template < typename COMMAND_T, bool TIERED >
+	static void __attribute__ ((always_inline)) exec(Machine< COMMAND_T, TIERED >& m) {
+		int input;
+		stream::cin >> input;
+		m.mem[m.dp] = word_t(input);
+	}
+};
+
+template <>
+struct Handler< OPCODE_OUTPUT > {
+	template < typename COMMAND_T, bool TIERED >
+	static void __attribute__ ((always_inline)) exec(Machine< COMMAND_T, TIERED >& m) {
+		print(m.mem[m.dp], m.print_ascii);
+	}
+};
+
+template <>
+struct Handler< OPCODE_ADD_WORD_AT > {
+	template < typename COMMAND_T, bool TIERED >
+	static void __attribute__ ((always_inline)) exec(Machine< COMMAND_T, TIERED >& m) {
+
+#if ENABLE_DIAGNOSTICS
+		if (m.dp + m.program[m.ip + 1].getDisp() >= m.dataLength) {
+			m.dp += m.program[m.ip + 1].getDisp();
+			return;
+		}
+
+#endif
+		++m.ip;
+		m.mem[m.dp + m.program[m.ip].getDisp()] += m.program[m.ip].getValue();
+	}
+};
+
+template <>
+struct Handler< OPCODE_INPUT_AT > {
+	template < typename COMMAND_T, bool TIERED >
+	static void __attribute__ ((always_inline)) exec(Machine< COMMAND_T, TIERED >& m) {
+
+#if ENABLE_DIAGNOSTICS
+		if (m.dp + m.program[m.ip + 1].getDisp() >= m.dataLength) {
+			m.dp += m.program[m.ip + 1].getDisp();
+			return;
+		}
+
+#endif
+		int input;
+		++m.ip;
+		stream::cin >> input;
+		m.mem[m.dp + m.program[m.ip].getDisp()] = word_t(input);
+	}
+};
+
+template <>
+struct Handler< OPCODE_OUTPUT_AT > {
+	template < typename COMMAND_T, bool TIERED >
+	static void __attribute__ ((always_inline)) exec(Machine< COMMAND_T, TIERED >& m) {
+
+#if ENABLE_DIAGNOSTICS
+		if (m.dp + m.program[m.ip + 1].getDisp() >= m.dataLength) {
+			m.dp += m.program[m.ip + 1].getDisp();
+			return;
+		}
+
+#endif
+		++m.ip;
+		print(m.mem[m.dp + m.program[m.ip].getDisp()], m.print_ascii);
+	}
+};
+
+template <>
+struct Handler< OPCODE_COND_L > {
+	template < typename COMMAND_T, bool TIERED >
+	static void __attribute__ ((always_inline)) exec(Machine< COMMAND_T, TIERED >& m) {
+		if (0 == m.mem[m.dp])
+			m.ip += size_t(m.program[m.ip].getOffset());
+
+#if __x86_64__ && ENABLE_DIAGNOSTICS == 0
+		else
+		if (TIERED) {
+			const size_t dp = m.tier->enter(m.ip, m.mem, m.dp);
+
+			if (Tier::cold != dp) {
+				m.dp = dp;
+				m.ip += size_t(m.program[m.ip].getOffset()); // resume past the loop
+			}
+		}
+
+#endif
+	}
+};
+
+template <>
+struct Handler< OPCODE_COND_R > {
+	template < typename COMMAND_T, bool TIERED >
+	static void __attribute__ ((always_inline)) exec(Machine< COMMAND_T, TIERED >& m) {
+		if (0 == m.mem[m.dp])
+			return;
+
+#if __x86_64__ && ENABLE_DIAGNOSTICS == 0
+		if (TIERED) {
+			const size_t dp = m.tier->enter(m.ip - size_t(m.program[m.ip].getOffset()), m.mem, m.dp);
+
+			if (Tier::cold != dp) {
+				m.dp = dp;
+				return; // resume past the loop
+			}
+		}
+
+#endif
+		m.ip -= size_t(m.program[m.ip].getOffset());
+	}
+};
+
+template <>
+struct Handler< OPCODE_ADD_PTR > {
+	template < typename COMMAND_T, bool TIERED >
+	static void __attribute__ ((always_inline)) exec(Machine< COMMAND_T, TIERED >& m) {
+		m.dp += size_t(m.program[m.ip].getArith());
+	}
+};
+
+template <>
+struct Handler< OPCODE_SUB_PTR > {
+	template < typename COMMAND_T, bool TIERED >
+	static void __attribute__ ((always_inline)) exec(Machine< COMMAND_T, TIERED >& m) {
+		m.dp -= size_t(m.program[m.ip].getArith());
+	}
+};
+
+// superinstruction handlers, from the handlers of their ops; in diagnostics builds, they stop short at an op
+// which leaves the data pointer out of bounds
+template < Opcode OP0, Opcode OP1 >
+struct Fused2 {
+	template < typename COMMAND_T, bool TIERED >
+	static void __attribute__ ((always_inline)) exec(Machine< COMMAND_T, TIERED >& m) {
+		++m.ip;
+		Handler< OP0 >::exec(m);
+
+		if (!inBounds(m))
+			return;
+
+		++m.ip;
+		Handler< OP1 >::exec(m);
+	}
+};
+
+template < Opcode OP0, Opcode OP1, Opcode OP2 >
+struct Fused3 {
+	template < typename COMMAND_T, bool TIERED >
+	static void __attribute__ ((always_inline)) exec(Machine< COMMAND_T, TIERED >& m) {
+		Fused2< OP0, OP1 >::exec(m);
+
+		if (!inBounds(m))
+			return;
+
+		++m.ip;
+		Handler< OP2 >::exec(m);
+	}
+};
+
+// run a program of either command form off code, with the data memory right past the program; in diagnostics
+// builds, record the n-grams of the dispatched ops into profile, and the branches run into loops, unless those
+// are nil; hand hot loops over to tier when TIERED
+template < typename COMMAND_T, bool TIERED >
+static int run(
+	const COMMAND_T* const code,
+	const size_t programLength,
+	const size_t dataLength,
+	const uint64_t terminalCount,
+	const bool print_ascii,
+	NgramProfile* const profile,
+	LoopProfile* const loops,
+	Tier* const tier) {
+
+	Machine< COMMAND_T, TIERED > m;
+	m.program = code;
+	m.mem = AlignedPtr< word_t, cacheline_size >(uintptr_t(code + programLength) + fold_range * sizeof(word_t))();
+	m.dataLength = dataLength;
+	m.ip = 0;
+	m.dp = 0;
+	m.print_ascii = print_ascii;
+	m.tier = tier;
+
+	uint64_t count = 0;
+	uint64_t dispatch = 0;
+
+#if ENABLE_DIAGNOSTICS
+	while (count < terminalCount &&
+		   m.ip < programLength &&
+		   m.dp < dataLength) {
+
+		const size_t pos = m.ip;
+
+#else
+	(void) terminalCount;
+	(void) profile;
+	(void) loops;
+
+	while (m.ip < programLength) {
+
+#endif
+		switch (uint32_t(m.program[m.ip].getOp())) {
+		case OPCODE_ADD_WORD:
+			Handler< OPCODE_ADD_WORD >::exec(m);
+			break;
+		case OPCODE_SET_WORD:
+			Handler< OPCODE_SET_WORD >::exec(m);
+			break;
+		case OPCODE_MUL_ADD:
+			Handler< OPCODE_MUL_ADD >::exec(m);
+			break;
+		case OPCODE_SCAN:
+			Handler< OPCODE_SCAN >::exec(m);
+			break;
+		case OPCODE_INPUT:
+			Handler< OPCODE_INPUT >::exec(m);
+			break;
+		case OPCODE_OUTPUT:
+			Handler< OPCODE_OUTPUT >::exec(m);
+			break;
+		case OPCODE_ADD_WORD_AT:
+			Handler< OPCODE_ADD_WORD_AT >::exec(m);
+			break;
+		case OPCODE_INPUT_AT:
+			Handler< OPCODE_INPUT_AT >::exec(m);
+			break;
+		case OPCODE_OUTPUT_AT:
+			Handler< OPCODE_OUTPUT_AT >::exec(m);
+			break;
+		case OPCODE_COND_L:
+			Handler< OPCODE_COND_L >::exec(m);
+			break;
+		case OPCODE_COND_R:
+			Handler< OPCODE_COND_R >::exec(m);
+			break;
+		case OPCODE_ADD_PTR:
+			Handler< OPCODE_ADD_PTR >::exec(m);
+			break;
+		case OPCODE_SUB_PTR:
+			Handler< OPCODE_SUB_PTR >::exec(m);
+			break;
+
+#define CASE2(index, op0, op1)                                 \
+		case OPCODE_FUSED + index:                             \
+			Fused2< OPCODE_##op0, OPCODE_##op1 >::exec(m);     \
+			count += 1;                                        \
+			break;
+#define CASE3(index, op0, op1, op2)                                         \
+		case OPCODE_FUSED + index:                                          \
+			Fused3< OPCODE_##op0, OPCODE_##op1, OPCODE_##op2 >::exec(m);    \
+			count += 2;                                                     \
+			break;
+
+		SUPERINSTRUCTIONS(CASE2, CASE3)
+
+#undef CASE2
+#undef CASE3
+		}
+
+#if ENABLE_DIAGNOSTICS
+		if (0 != profile)
+			profile->record(pos, successor(m.program, pos, false) != m.ip + 1);
+
+		if (0 != loops && (OPCODE_COND_L == m.program[pos].getOp() || OPCODE_COND_R == m.program[pos].getOp()))
+			loops->record(pos, OPCODE_COND_L == m.program[pos].getOp(), pos + 1 != m.ip + 1);
+
+#endif
+		++m.ip;
+		++count;
+		++dispatch;
+	}
+
+#if ENABLE_DIAGNOSTICS
+	if (m.dp >= dataLength) {
+		stream::cerr << "program error: out-of-bounds data pointer at ip " << m.ip - 1 << '\n';
+		return -1;
+	}
+
+	stream::cout << "\ninstructions executed: " << count << '\n';
+
+	if (dispatch != count)
+		stream::cout << "dispatches: " << count << " before fusion, " << dispatch << " after\n";
+
+#endif
+	return 0;
+}
+
+#if MULTIVERSION
+#if !__x86_64__ || __clang__ || __GNUC__ < 12
+#error multiversioning requires GCC 12 or later, targeting x86-64
+
+#endif
+#endif
+// target of the interpreter loop: in multiversioned builds, the loop gets compiled once per ISA level and
+// tuning target, and the one for the host gets picked at startup; other builds have just the build target
+enum Target {
+	TARGET_BUILD, // as the build flags have it
+	TARGET_X86_64_V2,
+	TARGET_X86_64_V3,
+	TARGET_X86_64_V4,
+
+	TARGET_COUNT
+};
+
+static const char* const target_name[TARGET_COUNT] = {
+	"build target",
+	"x86-64-v2",
+	"x86-64-v3",
+	"x86-64-v4"
+};
+
+#if MULTIVERSION
+// define name as run() compiled for the target of the given isa string, with everything it calls inlined into it;
+// the isa string takes no tune=, as GCC does not inline default-tuned callees into a differently-tuned caller
+#define RUN_TARGET(name, isa)                                                                     \
+template < typename COMMAND_T, bool TIERED >                                                      \
+static int __attribute__ ((target(isa), flatten, noinline)) name(                                 \
+	const COMMAND_T* const code,                                                                  \
+	const size_t programLength,                                                                   \
+	const size_t dataLength,                                                                      \
+	const uint64_t terminalCount,                                                                 \
+	const bool print_ascii,                                                                       \
+	NgramProfile* const profile,                                                                  \
+	LoopProfile* const loops,                                                                     \
+	Tier* const tier) {                                                                           \
+                                                                                                  \
+	return run< COMMAND_T, TIERED >(code, programLength, dataLength, terminalCount, print_ascii, profile, loops, tier); \
+}
+
+RUN_TARGET(runX86_64_v2, "arch=x86-64-v2")
+RUN_TARGET(runX86_64_v3, "arch=x86-64-v3")
+RUN_TARGET(runX86_64_v4, "arch=x86-64-v4")
+
+#undef RUN_TARGET
+
+#endif
+// pick the target of the interpreter loop for the host, by cpuid
+static Target pickTarget() {
+
+#if MULTIVERSION
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("x86-64-v4"))
+		return TARGET_X86_64_V4;
+
+	if (__builtin_cpu_supports("x86-64-v3"))
+		return TARGET_X86_64_V3;
+
+	if (__builtin_cpu_supports("x86-64-v2"))
+		return TARGET_X86_64_V2;
+
+#endif
+	return TARGET_BUILD;
+}
+
+// run a program of either command form by the interpreter loop of the given target
+template < typename COMMAND_T, bool TIERED >
+static int runTarget(
+	const Target target,
+	const COMMAND_T* const code,
+	const size_t programLength,
+	const size_t dataLength,
+	const uint64_t terminalCount,
+	const bool print_ascii,
+	NgramProfile* const profile,
+	LoopProfile* const loops,
+	Tier* const tier) {
+
+#if MULTIVERSION
+	switch (target) {
+	case TARGET_X86_64_V2:
+		return runX86_64_v2< COMMAND_T, TIERED >(code, programLength, dataLength, terminalCount, print_ascii, profile, loops, tier);
+	case TARGET_X86_64_V3:
+		return runX86_64_v3< COMMAND_T, TIERED >(code, programLength, dataLength, terminalCount, print_ascii, profile, loops, tier);
+	case TARGET_X86_64_V4:
+		return runX86_64_v4< COMMAND_T, TIERED >(code, programLength, dataLength, terminalCount, print_ascii, profile, loops, tier);
+	default:
+		break;
+	}
+
+#else
+	(void) target;
+
+#endif
+	return run< COMMAND_T, TIERED >(code, programLength, dataLength, terminalCount, print_ascii, profile, loops, tier);
+}
+
+// ops of the quickening engine: the forms the translated ops get specialised to when first run
+enum QuickOp {
+	QUICK_UNDECODED,   // not run yet
+	QUICK_ADD_WORD,    // OPCODE_ADD_WORD
+	QUICK_INC_WORD,    // OPCODE_ADD_WORD by 1
+	QUICK_DEC_WORD,    // OPCODE_ADD_WORD by -1
+	QUICK_SET_WORD,    // OPCODE_SET_WORD
+	QUICK_MOVE_PTR,    // OPCODE_ADD_PTR and OPCODE_SUB_PTR, by signed immediate
+	QUICK_ADD_PTR_1,   // OPCODE_ADD_PTR by 1
+	QUICK_SUB_PTR_1,   // OPCODE_SUB_PTR by 1
+	QUICK_MUL_ADD,     // OPCODE_MUL_ADD
+	QUICK_COPY_ADD,    // OPCODE_MUL_ADD by factor 1
+	QUICK_SCAN_FWD,    // OPCODE_SCAN by positive stride
+	QUICK_SCAN_REV,    // OPCODE_SCAN by negative stride
+	QUICK_ADD_WORD_AT, // OPCODE_ADD_WORD_AT
+	QUICK_INPUT,       // OPCODE_INPUT
+	QUICK_INPUT_AT,    // OPCODE_INPUT_AT
+	QUICK_OUTPUT,      // OPCODE_OUTPUT
+	QUICK_OUTPUT_AT,   // OPCODE_OUTPUT_AT
+	QUICK_JUMP_Z,      // OPCODE_COND_L, by resolved target
+	QUICK_JUMP_NZ      // OPCODE_COND_R, by resolved target
+};
+
+// pre-decoded op; it takes the place of the op word, and the operand word, if any, gets no use
+struct Quick {
+	uint8_t op;   // QuickOp
+	int8_t disp;  // displacement, from the operand word
+	word_t value; // value, from the operand word, or immediate of the op word
+	uint32_t imm; // pointer move, scan stride, or branch target
+};
+
+namespace {
+const compile_assert< 8 == sizeof(Quick) > assert_sizeof_quick;
+} // namespace annonymous
+
+// specialise the op at pos, as the quickening engine runs it
+static Quick quickenOp(
+	const Command32* const program,
+	const size_t pos) {
+
+	const Command32 cmd = program[pos];
+	Quick q = { QUICK_UNDECODED, 0, 0, 0 };
+
+	if (cmd.hasOperand()) {
+		q.disp = program[pos + 1].getDisp();
+		q.value = program[pos + 1].getValue();
+	}
+
+	switch (cmd.getOp()) {
+	case OPCODE_ADD_WORD:
+		q.value = word_t(cmd.getArith());
+		q.op = 1 == q.value ? QUICK_INC_WORD : word_t(-1) == q.value ? QUICK_DEC_WORD : QUICK_ADD_WORD;
+		break;
+	case OPCODE_SET_WORD:
+		q.op = QUICK_SET_WORD;
+		q.value = word_t(cmd.getOffset());
+		break;
+	case OPCODE_ADD_PTR:
+		q.op = 1 == cmd.getArith() ? QUICK_ADD_PTR_1 : QUICK_MOVE_PTR;
+		q.imm = cmd.getArith();
+		break;
+	case OPCODE_SUB_PTR:
+		q.op = 1 == cmd.getArith() ? QUICK_SUB_PTR_1 : QUICK_MOVE_PTR;
+		q.imm = uint32_t(-int32_t(cmd.getArith()));
+		break;
+	case OPCODE_MUL_ADD:
+		q.op = 1 == q.value ? QUICK_COPY_ADD : QUICK_MUL_ADD;
+		break;
+	case OPCODE_SCAN:
+		q.op = 0 < q.disp ? QUICK_SCAN_FWD : QUICK_SCAN_REV;
+		q.imm = uint32_t(0 < q.disp ? q.disp : -q.disp);
+		break;
+	case OPCODE_ADD_WORD_AT:
+		q.op = QUICK_ADD_WORD_AT;
+		break;
+	case OPCODE_INPUT:
+		q.op = QUICK_INPUT;
+		break;
+	case OPCODE_INPUT_AT:
+		q.op = QUICK_INPUT_AT;
+		break;
+	case OPCODE_OUTPUT:
+		q.op = QUICK_OUTPUT;
+		break;
+	case OPCODE_OUTPUT_AT:
+		q.op = QUICK_OUTPUT_AT;
+		break;
+	case OPCODE_COND_L:
+		q.op = QUICK_JUMP_Z;
+		q.imm = uint32_t(pos + cmd.getOffset() + 1);
+		break;
+	case OPCODE_COND_R:
+		q.op = QUICK_JUMP_NZ;
+		q.imm = uint32_t(pos - cmd.getOffset() + 1);
+		break;
+	default: // superinstructions are for the switch interpreter alone, and never reach quickening
+		assert(OPCODE_FUSED <= cmd.getOp() && cmd.getOp() < OPCODE_FUSED + superinstruction_count);
+		break;
+	}
+
+	return q;
+}
+
+// run a program by the quickening engine: each op gets replaced by its specialised form the first time it runs,
+// and later runs dispatch on that form without decoding
+static int runQuickened(
+	const Command32* const program,
+	const size_t programLength,
+	word_t* const mem,
+	const size_t dataLength,
+	const uint64_t terminalCount,
+	const bool print_ascii) {
+
+	using testbed::scoped_ptr;
+
+	const scoped_ptr< Quick, generic_free > quick(
+		reinterpret_cast< Quick* >(std::calloc(programLength + 1, sizeof(Quick))));
+
+	if (0 == quick()) {
+		stream::cerr << "failed to provide quickening memory\n";
+		return -1;
+	}
+
+	uint64_t count = 0;
+	size_t ip = 0;
+	size_t dp = 0;
+
+#if ENABLE_DIAGNOSTICS
+	size_t pos = 0; // position of the last op run
+
+	while (count < terminalCount &&
+		   ip < programLength &&
+		   dp < dataLength) {
+
+		pos = ip;
+
+#else
+	(void) terminalCount;
+
+	while (ip < programLength) {
+
+#endif
+		const Quick q = quick()[ip];
+		int input;
+
+		switch (q.op) {
+		case QUICK_UNDECODED:
+			quick()[ip] = quickenOp(program, ip);
+			continue;
+		case QUICK_ADD_WORD:
+			mem[dp] += q.value;
+			++ip;
+			break;
+		case QUICK_INC_WORD:
+			++mem[dp];
+			++ip;
+			break;
+		case QUICK_DEC_WORD:
+			--mem[dp];
+			++ip;
+			break;
+		case QUICK_SET_WORD:
+			mem[dp] = q.value;
+			++ip;
+			break;
+		case QUICK_MOVE_PTR:
+			dp += size_t(int32_t(q.imm));
+			++ip;
+			break;
+		case QUICK_ADD_PTR_1:
+			++dp;
+			++ip;
+			break;
+		case QUICK_SUB_PTR_1:
+			--dp;
+			++ip;
+			break;
+		case QUICK_MUL_ADD:
+
+#if ENABLE_DIAGNOSTICS
+			if (0 != mem[dp] && dp + q.disp >= dataLength) {
+				dp += q.disp;
+				break;
+			}
+
+#endif
+			mem[dp + q.disp] += mem[dp] * q.value;
+			ip += 2;
+			break;
+		case QUICK_COPY_ADD:
+
+#if ENABLE_DIAGNOSTICS
+			if (0 != mem[dp] && dp + q.disp >= dataLength) {
+				dp += q.disp;
+				break;
+			}
+
+#endif
+			mem[dp + q.disp] += mem[dp];
+			ip += 2;
+			break;
+		case QUICK_SCAN_FWD:
+			dp = scan::seek_zero_fwd(mem, dataLength, dp, q.imm);
+			ip += 2;
+			break;
+		case QUICK_SCAN_REV:
+			dp = scan::seek_zero_rev(mem, dataLength, dp, q.imm);
+			ip += 2;
+			break;
+		case QUICK_ADD_WORD_AT:
+
+#if ENABLE_DIAGNOSTICS
+			if (dp + q.disp >= dataLength) {
+				dp += q.disp;
+				break;
+			}
+
+#endif
+			mem[dp + q.disp] += q.value;
+			ip += 2;
+			break;
+		case QUICK_INPUT:
+			stream::cin >> input;
+			mem[dp] = word_t(input);
+			++ip;
+			break;
+		case QUICK_INPUT_AT:
+
+#if ENABLE_DIAGNOSTICS
+			if (dp + q.disp >= dataLength) {
+				dp += q.disp;
+				break;
+			}
+
+#endif
+			stream::cin >> input;
+			mem[dp + q.disp] = word_t(input);
+			ip += 2;
+			break;
+		case QUICK_OUTPUT:
+			print(mem[dp], print_ascii);
+			++ip;
+			break;
+		case QUICK_OUTPUT_AT:
+
+#if ENABLE_DIAGNOSTICS
+			if (dp + q.disp >= dataLength) {
+				dp += q.disp;
+				break;
+			}
+
+#endif
+			print(mem[dp + q.disp], print_ascii);
+			ip += 2;
+			break;
+		case QUICK_JUMP_Z:
+			ip = 0 == mem[dp] ? size_t(q.imm) : ip + 1;
+			break;
+		case QUICK_JUMP_NZ:
+			ip = 0 != mem[dp] ? size_t(q.imm) : ip + 1;
+			break;
+		}
+
+		++count;
+	}
+
+#if ENABLE_DIAGNOSTICS
+	if (dp >= dataLength) {
+		stream::cerr << "program error: out-of-bounds data pointer at ip " << pos << '\n';
+		return -1;
+	}
+
+	stream::cout << "\ninstructions executed: " << count << '\n';
+
+#endif
+	return 0;
+}
+
+#if __x86_64__ && ENABLE_DIAGNOSTICS == 0
+// read a word off the input, on behalf of native code
+static word_t readWord() {
+	int input;
+	stream::cin >> input;
+	return word_t(input);
+}
+
+// compile the loop of the COND_L at pos; return false if not possible
+bool Tier::compile(const size_t pos) {
+	const size_t end = pos + size_t(program[pos].delta) + 1;
+	const size_t start = code.size();
+
+	if (code.room() < (end - pos) * jit::Code::max_command_size + jit::Code::max_frame_size || !code.reopen())
+		return false;
+
+	code.loopPrologue();
+	backend::emitCommands(code, program, pos, end, print_ascii, readWord, print, loop);
+	code.loopEpilogue();
+
+	native[pos] = code.finalizeLoop(start);
+
+	// without the code executable, no loop compiled so far can run
+	if (0 == native[pos])
+		std::memset(native, 0, (programLength + 1) * sizeof(jit::loop_t));
+
+	return 0 != native[pos];
+}
+
+#endif
+// monotonic time in nanoseconds
+static uint64_t getTime() {
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return uint64_t(t.tv_sec) * 1000000000 + uint64_t(t.tv_nsec);
+}
+
+// spin through rounds of 8 dependent register-to-register adds, of a cycle of latency each on any core of either
+// ISA, so that the spin takes a known number of core cycles; return that, or 0 if there is no such spin
+static uint64_t spinAdds(const uint64_t rounds) {
+	uint64_t acc = 0;
+	uint64_t count = rounds;
+	const uint64_t one = 1;
+
+#if __x86_64__
+	asm volatile (
+		"1:\n\t"
+		"add %2, %0\n\t" "add %2, %0\n\t" "add %2, %0\n\t" "add %2, %0\n\t"
+		"add %2, %0\n\t" "add %2, %0\n\t" "add %2, %0\n\t" "add %2, %0\n\t"
+		"dec %1\n\t"
+		"jnz 1b"
+		: "+r" (acc), "+r" (count)
+		: "r" (one)
+		: "cc");
+
+#elif __aarch64__
+	asm volatile (
+		"1:\n\t"
+		"add %0, %0, %2\n\t" "add %0, %0, %2\n\t" "add %0, %0, %2\n\t" "add %0, %0, %2\n\t"
+		"add %0, %0, %2\n\t" "add %0, %0, %2\n\t" "add %0, %0, %2\n\t" "add %0, %0, %2\n\t"
+		"subs %1, %1, #1\n\t"
+		"b.ne 1b"
+		: "+r" (acc), "+r" (count)
+		: "r" (one)
+		: "cc");
+
+#else
+	(void) one;
+
+#endif
+	return acc;
+}
+
+// clock of the core in GHz, as measured by a spin of dependent adds against the monotonic clock, right after
+// another one to get the core up to speed; 0 if there is no such spin
+static double measureGhz() {
+	const uint64_t rounds = 1 << 22;
+
+	spinAdds(rounds);
+
+	const uint64_t startTime = getTime();
+	const uint64_t cycles = spinAdds(rounds);
+
+	return double(cycles) / double(getTime() - startTime);
+}
+
+// order of run durations, for qsort
+static int compareDuration(
+	const void* a,
+	const void* b) {
+
+	const uint64_t da = *reinterpret_cast< const uint64_t* >(a);
+	const uint64_t db = *reinterpret_cast< const uint64_t* >(b);
+	return da < db ? -1 : da > db ? 1 : 0;
+}
+
+// durations of repeated runs of a program, and their statistics; those normalise to core cycles as
+// duration x GHz, for comparison across clock speeds
+class RunTimes {
+	uint64_t* duration; // [run], in nanoseconds
+	size_t count;
+	size_t capacity;
+	uint64_t startTime;
+
+	RunTimes(); // undefined
+	RunTimes(const RunTimes&); // undefined
+
+public:
+	RunTimes(const size_t runs)
+	: duration(reinterpret_cast< uint64_t* >(std::calloc(runs, sizeof(uint64_t))))
+	, count(0)
+	, capacity(runs)
+	, startTime(0) {
+	}
+
+	~RunTimes() {
+		std::free(duration);
+	}
+
+	bool valid() const {
+		return 0 != duration;
+	}
+
+	void start() {
+		startTime = getTime();
+	}
+
+	void stop() {
+		const uint64_t time = getTime();
+
+		if (count < capacity)
+			duration[count++] = time - startTime;
+	}
+
+	// print the statistics of the runs so far as a single-line JSON object; sorts the durations
+	void report(stream::out& out) {
+		if (0 == count)
+			return;
+
+		std::qsort(duration, count, sizeof(duration[0]), compareDuration);
+
+		double total = 0;
+
+		for (size_t i = 0; i < count; ++i)
+			total += double(duration[i]);
+
+		const double mean = total / count;
+		double variance = 0;
+
+		for (size_t i = 0; i < count; ++i)
+			variance += (double(duration[i]) - mean) * (double(duration[i]) - mean);
+
+		variance = 1 < count ? variance / (count - 1) : 0;
+
+		const double deviation = std::sqrt(variance);
+		const double median = count & 1
+			? double(duration[count / 2])
+			: .5 * (double(duration[count / 2 - 1]) + double(duration[count / 2]));
+
+		const double ghz = measureGhz();
+
+		out << "{\"runs\": " << uint64_t(count) <<
+			", \"min_ns\": " << duration[0] <<
+			", \"median_ns\": " << uint64_t(median) <<
+			", \"stddev_ns\": " << uint64_t(deviation) <<
+			", \"ghz\": " << ghz <<
+			", \"min_cycles\": " << uint64_t(double(duration[0]) * ghz) <<
+			", \"median_cycles\": " << uint64_t(median * ghz) << "}\n";
+	}
+};
+
+int main(
+	int argc,
 	char** argv) {
 
 	using testbed::scoped_ptr;
@@ -372,6 +2832,11 @@ int main(
 	param.terminalCount = default_terminal_count;
 	param.flags = 0;
 	param.filename = 0;
+	param.output = 0;
+	param.ngramProfile = 0;
+	param.loopProfile = 0;
+	param.superinstructions = 0;
+	param.repeat = 0;
 
 	const int result_cli = parse_cli(argc, argv, param);
 
@@ -380,6 +2845,21 @@ int main(
 
 	const bool print_ascii = bool(param.flags & cli_param::FLAG_PRINT_ASCII);
 
+#if QUICKEN
+	const bool quicken = true;
+
+#else
+	const bool quicken = bool(param.flags & cli_param::FLAG_QUICKEN);
+
+#endif
+	const bool profiled = 0 != param.ngramProfile || 0 != param.loopProfile;
+
+	// repeated runs are up to the interpreter loop alone; the other paths run the program once, if at all
+	if (0 != param.repeat && ((param.flags & (cli_param::FLAG_JIT | cli_param::FLAG_EMIT_C)) || 0 != param.output || (quicken && !profiled))) {
+		stream::cerr << arg_prefix << arg_repeat << " is unsupported with native code, translation output and quickening\n";
+		return 1;
+	}
+
 	size_t sourceLength = 0;
 	const scoped_ptr< char, generic_free > source(
 		reinterpret_cast< char* >(get_buffer_from_file(param.filename, sourceLength)));
@@ -391,96 +2871,204 @@ int main(
 
 	const size_t dataLength = param.memorySize;
 
-	scoped_ptr< void, generic_free > space(
-		std::calloc(sourceLength * sizeof(Command) + dataLength * sizeof(word_t) + mempage_size + cacheline_size, sizeof(int8_t)));
+	const scoped_ptr< Command32, generic_free > ir(
+		reinterpret_cast< Command32* >(std::calloc(4 * sourceLength, sizeof(Command32))));
 
-	if (0 == space()) {
-		stream::cerr << "failed to provide program and data memory\n";
+	if (0 == ir()) {
+		stream::cerr << "failed to provide program memory\n";
 		return 0;
 	}
 
-	const AlignedPtr< Command, mempage_size > code((uintptr_t(space())));
+	// a loop profile maps the program back to the source
+	const scoped_ptr< size_t, generic_free > origin(0 != param.loopProfile
+		? reinterpret_cast< size_t* >(std::calloc(4 * sourceLength, sizeof(size_t))) : 0);
+
+	if (0 != param.loopProfile && 0 == origin()) {
+		stream::cerr << "failed to provide source map memory\n";
+		return -1;
+	}
+
 	size_t programLength = 0;
 
-	const Ptr< Command > program(
-		translate(source(), sourceLength, code(), programLength));
+	const Ptr< Command32 > wide(
+		translate(source(), sourceLength, ir(), programLength, origin()));
 
-	if (!program()) {
+	if (!wide()) {
 		stream::cerr << "unable to provide program IR\n";
 		return -1;
 	}
 
-	const AlignedPtr< word_t, cacheline_size > mem(uintptr_t(code() + programLength));
+	// the backends which translate the program, rather than interpret it, take it decoded
+	const bool decoded = (param.flags & (cli_param::FLAG_EMIT_C | cli_param::FLAG_JIT)) || 0 != param.output;
+	const scoped_ptr< backend::Op, generic_free > ops(decoded ? decode(wide(), programLength) : 0);
 
-	uint64_t count = 0;
-	const uint64_t terminalCount = param.terminalCount;
-	size_t ip = 0;
-	size_t dp = 0;
+	if (decoded && 0 == ops()) {
+		stream::cerr << "unable to provide program IR\n";
+		return -1;
+	}
 
-#if ENABLE_DIAGNOSTICS
-	while (count < terminalCount &&
-		   ip < programLength &&
-		   dp < dataLength) {
+	if (param.flags & cli_param::FLAG_EMIT_C) {
+		backend::emitC(stream::cout, ops(), programLength, dataLength, PRINT_ASCII || print_ascii, param.filename);
+		return 0;
+	}
+
+	if (0 != param.output) {
+
+#if __x86_64__
+		if (backend::writeStandalone(ops(), programLength, dataLength, PRINT_ASCII || print_ascii, param.output))
+			return 0;
+
+		stream::cerr << "failed to write standalone executable\n";
 
 #else
-	while (ip < programLength) {
+		stream::cerr << "standalone executables unsupported by this build\n";
 
 #endif
-		const Command cmd = program()[ip];
-		int input;
+		return -1;
+	}
 
-		switch (cmd.getOp()) {
-		case OPCODE_INC_WORD:
-			++mem()[dp];
-			break;
-		case OPCODE_DEC_WORD:
-			--mem()[dp];
-			break;
-		case OPCODE_INPUT:
-			stream::cin >> input;
-			mem()[dp] = word_t(input);
-			break;
-		case OPCODE_OUTPUT:
+	// the switch interpreter may run a copy of the program with superinstructions, unless that gets profiled
+	scoped_ptr< Command32, generic_free > fused;
+	const Command32* interp = wide();
+	size_t interpLength = programLength;
 
-#if PRINT_ASCII
-			stream::cout << char(mem()[dp]);
+	if (0 != param.superinstructions && !profiled && !quicken) {
+		scoped_ptr< Command32, generic_free > buffer(
+			reinterpret_cast< Command32* >(std::calloc(programLength + programLength / 2 + 1, sizeof(Command32))));
+
+		fused.swap(buffer);
+		interp = fuse(wide(), programLength, param.superinstructions, fused(), interpLength);
+
+		if (0 == interp) {
+			stream::cerr << "failed to fuse superinstructions\n";
+			return -1;
+		}
+	}
+
+	// program, then tape; closed-form loops may touch words up to fold_range either side of the tape even when they
+	// do not run, so pad it by that much
+	const scoped_ptr< void, generic_free > space(
+		std::calloc(interpLength * sizeof(Command32) + (dataLength + 2 * fold_range) * sizeof(word_t) + mempage_size + 2 * cacheline_size, sizeof(int8_t)));
+
+	if (0 == space()) {
+		stream::cerr << "failed to provide program and data memory\n";
+		return 0;
+	}
+
+#if __x86_64__ && ENABLE_DIAGNOSTICS == 0
+	if (param.flags & cli_param::FLAG_JIT) {
+		const AlignedPtr< word_t, cacheline_size > mem(uintptr_t(space()) + fold_range * sizeof(word_t));
+
+		if (backend::runNative(ops(), programLength, mem(), dataLength, print_ascii, readWord, print))
+			return 0;
+
+		stream::cerr << "failed to compile program to native code; interpreting instead\n";
+	}
 
 #else
-			if (print_ascii)
-				stream::cout << char(mem()[dp]);
-			else
-				stream::cout << mem()[dp] << ' ';
+	if (param.flags & cli_param::FLAG_JIT)
+		stream::cerr << "native code unsupported by this build; interpreting instead\n";
 
 #endif
-			break;
-		case OPCODE_COND_L:
-			if (0 == mem()[dp])
-				ip += size_t(cmd.getOffset());
-			break;
-		case OPCODE_COND_R:
-			if (0 != mem()[dp])
-				ip -= size_t(cmd.getOffset());
-			break;
-		case OPCODE_ADD_PTR:
-			dp += size_t(cmd.getArith());
-			break;
-		case OPCODE_SUB_PTR:
-			dp -= size_t(cmd.getArith());
-			break;
-		}
+	// run the compact form of the program whenever that fits, for its cache density
+	const AlignedPtr< Command16, mempage_size > code16((uintptr_t(space())));
 
-		++ip;
-		++count;
+	if (quicken && !profiled) {
+		const AlignedPtr< word_t, cacheline_size > mem(uintptr_t(space()) + programLength * sizeof(Command32) + fold_range * sizeof(word_t));
+		return runQuickened(wide(), programLength, mem(), dataLength, param.terminalCount, print_ascii);
 	}
 
-#if ENABLE_DIAGNOSTICS
-	if (dp >= dataLength) {
-		stream::cerr << "program error: out-of-bounds data pointer at ip " << ip - 1 << '\n';
+	NgramProfile profile(0 != param.ngramProfile ? interpLength : 0);
+	NgramProfile* const record = 0 != param.ngramProfile ? &profile : 0;
+
+	if (0 != record && !profile.valid()) {
+		stream::cerr << "failed to provide n-gram profile memory\n";
 		return -1;
 	}
 
-	stream::cout << "\ninstructions executed: " << count << '\n';
+	const scoped_ptr< LoopProfile, testbed::generic_delete > loops(
+		0 != param.loopProfile ? new LoopProfile(interp, interpLength) : 0);
+
+	if (0 != loops() && !loops()->valid()) {
+		stream::cerr << "failed to provide loop profile memory\n";
+		return -1;
+	}
+
+#if __x86_64__ && ENABLE_DIAGNOSTICS == 0
+	const scoped_ptr< Tier, testbed::generic_delete > upper(
+		param.flags & cli_param::FLAG_TIERED ? new Tier(interp, interpLength, dataLength, print_ascii) : 0);
+	Tier* const tier = upper();
+
+	if (0 != tier && !tier->valid()) {
+		stream::cerr << "failed to provide native code memory\n";
+		return -1;
+	}
+
+#else
+	Tier* const tier = 0;
+
+	if (param.flags & cli_param::FLAG_TIERED)
+		stream::cerr << "native code unsupported by this build; interpreting only\n";
 
 #endif
-	return 0;
+	const Target target = pickTarget();
+
+	if (param.flags & cli_param::FLAG_SHOW_ENGINE)
+		stream::cerr << "interpreter loop target: " << target_name[target] << '\n';
+
+	// translate to the run form once; repeated runs only get the tape zeroed in between
+	const bool compact = narrow(interp, interpLength, code16());
+	const AlignedPtr< Command32, mempage_size > code32((uintptr_t(space())));
+
+	if (!compact)
+		std::memcpy(code32(), interp, interpLength * sizeof(Command32));
+
+	word_t* const mem = compact
+		? AlignedPtr< word_t, cacheline_size >(uintptr_t(code16() + interpLength) + fold_range * sizeof(word_t))()
+		: AlignedPtr< word_t, cacheline_size >(uintptr_t(code32() + interpLength) + fold_range * sizeof(word_t))();
+
+	const size_t runs = 0 != param.repeat ? param.repeat : 1;
+	RunTimes times(runs);
+
+	if (!times.valid()) {
+		stream::cerr << "failed to provide timing memory\n";
+		return -1;
+	}
+
+	int result = 0;
+
+	for (size_t i = 0; i < runs && 0 == result; ++i) {
+		if (0 != i)
+			std::memset(mem, 0, dataLength * sizeof(word_t));
+
+		times.start();
+
+		if (compact)
+			result = 0 != tier ?
+				runTarget< Command16, true >(target, code16(), interpLength, dataLength, param.terminalCount, print_ascii, record, loops(), tier) :
+				runTarget< Command16, false >(target, code16(), interpLength, dataLength, param.terminalCount, print_ascii, record, loops(), tier);
+		else
+			result = 0 != tier ?
+				runTarget< Command32, true >(target, code32(), interpLength, dataLength, param.terminalCount, print_ascii, record, loops(), tier) :
+				runTarget< Command32, false >(target, code32(), interpLength, dataLength, param.terminalCount, print_ascii, record, loops(), tier);
+
+		// the printout counts towards the run
+		stream::cout.flush();
+		times.stop();
+	}
+
+	if (0 != param.repeat)
+		times.report(stream::cerr);
+
+	if (0 != record && !profile.write(interp, param.ngramProfile)) {
+		stream::cerr << "failed to write n-gram profile\n";
+		return -1;
+	}
+
+	if (0 != loops() && !loops()->write(interp, origin(), source(), sourceLength, param.loopProfile)) {
+		stream::cerr << "failed to write loop profile\n";
+		return -1;
+	}
+
+	return result;
 }
@@ -0,0 +1,336 @@
+#include "frontend.hpp"
+#include "stencil.hpp"
+#if __x86_64__
+#include <sys/mman.h>
+#endif
+
+// run a program of either command form off code, with the data memory right past the program
+template < typename COMMAND_T >
+static int run(
+	const COMMAND_T* const code,
+	const size_t programLength,
+	const size_t dataLength,
+	const uint64_t terminalCount,
+	const bool print_ascii) {
+
+	const Ptr< const COMMAND_T > program(code);
+	const AlignedPtr< word_t, cacheline_size > mem(uintptr_t(code + programLength) + fold_range * sizeof(word_t));
+
+	uint64_t count = 0;
+	size_t ip = 0;
+	size_t dp = 0;
+
+#if ENABLE_DIAGNOSTICS
+	while (count < terminalCount &&
+		   ip < programLength &&
+		   dp < dataLength) {
+
+#else
+	(void) terminalCount;
+
+	while (ip < programLength) {
+
+#endif
+		const COMMAND_T cmd = program()[ip];
+		int input;
+
+		switch (cmd.getOp()) {
+		case OPCODE_ADD_WORD:
+			mem()[dp] += word_t(cmd.getArith());
+			break;
+		case OPCODE_SET_WORD:
+			mem()[dp] = word_t(cmd.getOffset());
+			break;
+		case OPCODE_MUL_ADD:
+
+#if ENABLE_DIAGNOSTICS
+			if (0 != mem()[dp] && dp + program()[ip + 1].getDisp() >= dataLength) {
+				dp += program()[ip + 1].getDisp();
+				break;
+			}
+
+#endif
+			++ip;
+			mem()[dp + program()[ip].getDisp()] += mem()[dp] * program()[ip].getValue();
+			break;
+		case OPCODE_SCAN:
+			++ip;
+			if (0 < program()[ip].getDisp())
+				dp = scan::seek_zero_fwd(mem(), dataLength, dp, size_t(program()[ip].getDisp()));
+			else
+				dp = scan::seek_zero_rev(mem(), dataLength, dp, size_t(-program()[ip].getDisp()));
+			break;
+		case OPCODE_INPUT:
+			stream::cin >> input;
+			mem()[dp] = word_t(input);
+			break;
+		case OPCODE_OUTPUT:
+			print(mem()[dp], print_ascii);
+			break;
+		case OPCODE_ADD_WORD_AT:
+
+#if ENABLE_DIAGNOSTICS
+			if (dp + program()[ip + 1].getDisp() >= dataLength) {
+				dp += program()[ip + 1].getDisp();
+				break;
+			}
+
+#endif
+			++ip;
+			mem()[dp + program()[ip].getDisp()] += program()[ip].getValue();
+			break;
+		case OPCODE_INPUT_AT:
+
+#if ENABLE_DIAGNOSTICS
+			if (dp + program()[ip + 1].getDisp() >= dataLength) {
+				dp += program()[ip + 1].getDisp();
+				break;
+			}
+
+#endif
+			++ip;
+			stream::cin >> input;
+			mem()[dp + program()[ip].getDisp()] = word_t(input);
+			break;
+		case OPCODE_OUTPUT_AT:
+
+#if ENABLE_DIAGNOSTICS
+			if (dp + program()[ip + 1].getDisp() >= dataLength) {
+				dp += program()[ip + 1].getDisp();
+				break;
+			}
+
+#endif
+			++ip;
+			print(mem()[dp + program()[ip].getDisp()], print_ascii);
+			break;
+		case OPCODE_COND_L:
+			if (0 == mem()[dp])
+				ip += size_t(cmd.getOffset());
+			break;
+		case OPCODE_COND_R:
+			if (0 != mem()[dp])
+				ip -= size_t(cmd.getOffset());
+			break;
+		case OPCODE_ADD_PTR:
+			dp += size_t(cmd.getArith());
+			break;
+		case OPCODE_SUB_PTR:
+			dp -= size_t(cmd.getArith());
+			break;
+		}
+
+		++ip;
+		++count;
+	}
+
+#if ENABLE_DIAGNOSTICS
+	if (dp >= dataLength) {
+		stream::cerr << "program error: out-of-bounds data pointer at ip " << ip - 1 << '\n';
+		return -1;
+	}
+
+	stream::cout << "\ninstructions executed: " << count << '\n';
+
+#endif
+	return 0;
+}
+
+#if __x86_64__ && ENABLE_DIAGNOSTICS == 0
+#include "stencils.inc"
+
+// add value to the 64-bit hole at the given position in code
+static void patchHole(
+	uint8_t* const code,
+	const size_t pos,
+	const uint64_t value) {
+
+	uint64_t hole;
+	std::memcpy(&hole, code + pos, sizeof(hole));
+	hole += value;
+	std::memcpy(code + pos, &hole, sizeof(hole));
+}
+
+// append a copy of the stencil of the given id to code, with its holes patched from value, save for
+// branch targets, which are left to the caller; return the position of the branch-target hole, if any
+static size_t stitch(
+	uint8_t* const code,
+	size_t& length,
+	const stencil::Id id,
+	uint64_t (& value)[stencil::HOLE_COUNT]) {
+
+	const stencil::Stencil& s = stencils[id];
+	size_t target = 0;
+
+	std::memcpy(code + length, s.code, s.size);
+	value[stencil::HOLE_CONT] = uintptr_t(code + length + s.size);
+
+	for (size_t i = 0; i < s.count; ++i) {
+		const stencil::Patch& p = s.patch[i];
+
+		std::memcpy(code + length + p.offset, &p.addend, sizeof(p.addend));
+
+		if (stencil::HOLE_TARGET == p.hole)
+			target = length + p.offset;
+		else
+			patchHole(code, length + p.offset, value[p.hole]);
+	}
+
+	length += s.size;
+	return target;
+}
+
+// stitch the stencils of a program together into native code, and run that on the data memory; return
+// false if not possible
+static bool runStitched(
+	const Command32* const program,
+	const size_t programLength,
+	word_t* const mem,
+	const size_t dataLength,
+	const bool print_ascii) {
+
+	using testbed::scoped_ptr;
+
+	size_t maxSize = 0;
+
+	for (size_t id = 0; id < stencil::ID_COUNT; ++id)
+		if (maxSize < stencils[id].size)
+			maxSize = stencils[id].size;
+
+	const size_t capacity = (programLength + 1) * maxSize;
+	void* const buf = mmap(0, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (MAP_FAILED == buf)
+		return false;
+
+	// position of the branch-target hole, and the position past the copy, of each '['
+	const scoped_ptr< size_t, generic_free > loop(
+		reinterpret_cast< size_t* >(std::calloc(2 * programLength + 1, sizeof(size_t))));
+
+	if (0 == loop()) {
+		munmap(buf, capacity);
+		return false;
+	}
+
+	uint8_t* const code = static_cast< uint8_t* >(buf);
+	size_t length = 0;
+	uint64_t value[stencil::HOLE_COUNT] = { 0 };
+
+	value[stencil::HOLE_ASCII] = print_ascii;
+	value[stencil::HOLE_INPUT] = uintptr_t(readWord);
+	value[stencil::HOLE_OUTPUT] = uintptr_t(print);
+	value[stencil::HOLE_SEEK_FWD] = uintptr_t(scan::seek_zero_fwd);
+	value[stencil::HOLE_SEEK_REV] = uintptr_t(scan::seek_zero_rev);
+
+	for (size_t i = 0; i < programLength; ++i) {
+		const Command32 cmd = program[i];
+		size_t open;
+
+		switch (cmd.getOp()) {
+		case OPCODE_ADD_WORD:
+			value[stencil::HOLE_IMM] = word_t(cmd.getArith());
+			stitch(code, length, stencil::ADD_WORD, value);
+			break;
+		case OPCODE_SET_WORD:
+			value[stencil::HOLE_IMM] = word_t(cmd.getOffset());
+			stitch(code, length, stencil::SET_WORD, value);
+			break;
+		case OPCODE_ADD_PTR:
+			value[stencil::HOLE_DISP] = uint64_t(cmd.getArith());
+			stitch(code, length, stencil::MOVE_PTR, value);
+			break;
+		case OPCODE_SUB_PTR:
+			value[stencil::HOLE_DISP] = -uint64_t(cmd.getArith());
+			stitch(code, length, stencil::MOVE_PTR, value);
+			break;
+		case OPCODE_COND_L:
+			loop()[2 * i] = stitch(code, length, stencil::COND_L, value);
+			loop()[2 * i + 1] = length;
+			break;
+		case OPCODE_COND_R:
+			open = 2 * (i - cmd.getOffset());
+			patchHole(code, stitch(code, length, stencil::COND_R, value), uintptr_t(code + loop()[open + 1]));
+			patchHole(code, loop()[open], uintptr_t(code + length));
+			break;
+		case OPCODE_INPUT:
+			stitch(code, length, stencil::INPUT, value);
+			break;
+		case OPCODE_OUTPUT:
+			stitch(code, length, stencil::OUTPUT, value);
+			break;
+		case OPCODE_MUL_ADD:
+			++i;
+			value[stencil::HOLE_DISP] = uint64_t(int64_t(program[i].getDisp()));
+			value[stencil::HOLE_IMM] = program[i].getValue();
+			stitch(code, length, stencil::MUL_ADD, value);
+			break;
+		case OPCODE_SCAN:
+			++i;
+			value[stencil::HOLE_DISP] = uint64_t(0 < program[i].getDisp() ? program[i].getDisp() : -program[i].getDisp());
+			stitch(code, length, 0 < program[i].getDisp() ? stencil::SCAN_FWD : stencil::SCAN_REV, value);
+			break;
+		case OPCODE_ADD_WORD_AT:
+			++i;
+			value[stencil::HOLE_DISP] = uint64_t(int64_t(program[i].getDisp()));
+			value[stencil::HOLE_IMM] = program[i].getValue();
+			stitch(code, length, stencil::ADD_WORD_AT, value);
+			break;
+		case OPCODE_INPUT_AT:
+			++i;
+			value[stencil::HOLE_DISP] = uint64_t(int64_t(program[i].getDisp()));
+			stitch(code, length, stencil::INPUT_AT, value);
+			break;
+		case OPCODE_OUTPUT_AT:
+			++i;
+			value[stencil::HOLE_DISP] = uint64_t(int64_t(program[i].getDisp()));
+			stitch(code, length, stencil::OUTPUT_AT, value);
+			break;
+		}
+	}
+
+	stitch(code, length, stencil::END, value);
+
+	if (0 != mprotect(buf, capacity, PROT_READ | PROT_EXEC)) {
+		munmap(buf, capacity);
+		return false;
+	}
+
+	reinterpret_cast< stencil::entry_t >(buf)(mem, mem, dataLength);
+
+	munmap(buf, capacity);
+	return true;
+}
+
+#endif
+// stitch the program out of its stencils and run that, where supported; otherwise, or failing that, run the
+// compact form of the program whenever that fits, for its cache density
+static int interpret(
+	const Command32* const wide,
+	const size_t programLength,
+	void* const space,
+	const size_t dataLength,
+	const cli_param& param) {
+
+	const bool print_ascii = bool(param.flags & cli_param::FLAG_PRINT_ASCII);
+
+#if __x86_64__ && ENABLE_DIAGNOSTICS == 0
+	{
+		const AlignedPtr< word_t, cacheline_size > mem(uintptr_t(space) + fold_range * sizeof(word_t));
+
+		if (runStitched(wide, programLength, mem(), dataLength, print_ascii))
+			return 0;
+
+		stream::cerr << "failed to stitch program stencils; interpreting instead\n";
+	}
+
+#endif
+	const AlignedPtr< Command16, mempage_size > code16((uintptr_t(space)));
+
+	if (narrow(wide, programLength, code16()))
+		return run(code16(), programLength, dataLength, param.terminalCount, print_ascii);
+
+	const AlignedPtr< Command32, mempage_size > code32((uintptr_t(space)));
+	std::memcpy(code32(), wide, programLength * sizeof(Command32));
+
+	return run(code32(), programLength, dataLength, param.terminalCount, print_ascii);
+}
@@ -0,0 +1,326 @@
+// all-engines build: the vanilla, alt and alt-alt versions, each wrapped in a namespace of its own, with
+// the engine picked at startup by -engine, or by a calibration run whose winner gets cached per CPU model
+#include <stdint.h>
+#include <cassert>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <time.h>
+#include <unistd.h>
+#include "stream.hpp"
+#include "scoped.hpp"
+#include "util_file.hpp"
+#include "scan.hpp"
+#include "jit.hpp"
+#include "backend.hpp"
+
+// each version defines the standard streams of its own, on top of the shared stream facilities
+#define ENGINE_NAMESPACE(name)               \
+	namespace name {                         \
+	namespace stream {                       \
+	using namespace ::stream;                \
+	}                                        \
+	}
+
+ENGINE_NAMESPACE(vanilla)
+ENGINE_NAMESPACE(alt)
+ENGINE_NAMESPACE(alt_alt)
+
+#undef ENGINE_NAMESPACE
+#define main engineMain
+
+namespace vanilla {
+#include "main.cpp"
+} // namespace vanilla
+
+namespace alt {
+#include "main_alt.cpp"
+} // namespace alt
+
+namespace alt_alt {
+#include "main_alt_alt.cpp"
+} // namespace alt_alt
+
+#undef main
+
+namespace stream {
+// deferred initialization by main()
+in cin;
+out cout;
+out cerr;
+} // namespace stream
+
+typedef int (*engine_t)(int argc, char** argv);
+
+static const char arg_engine[] = "-engine";
+static const char engine_auto[] = "auto";
+static const char engine_cache[] = ".brinterp_engine";
+
+static const char* const engine_name[] = {
+	"vanilla",
+	"alt",
+	"alt_alt"
+};
+
+static const engine_t engine_main[] = {
+	vanilla::engineMain,
+	alt::engineMain,
+	alt_alt::engineMain
+};
+
+static const size_t engine_count = sizeof(engine_main) / sizeof(engine_main[0]);
+
+// calibration program: nested loops of word arithmetics and pointer moves, which fold into no closed
+// form due to their even counter steps; it runs some ten million steps, and prints nothing
+static const char calibration_source[] =
+	"++++++++++[>++++++++++<-]>[>--[>--[>+>++>+++<<<--]>[>+<-]>>[-]<<<<--]<-]";
+
+static const size_t calibration_runs = 3;
+
+// index of the engine of the given name; return engine_count if none
+static size_t findEngine(const char* const name) {
+	size_t i = 0;
+
+	while (i < engine_count && std::strcmp(engine_name[i], name))
+		++i;
+
+	return i;
+}
+
+// get the CPU model off /proc/cpuinfo into model, as a single line; return false if unavailable
+static bool getCpuModel(
+	char* const model,
+	const size_t size) {
+
+	FILE* const f = std::fopen("/proc/cpuinfo", "r");
+
+	if (0 == f)
+		return false;
+
+	static const char* const key[] = {
+		"model name",      // x86
+		"CPU implementer", // arm
+		"CPU part"         // arm
+	};
+
+	char line[256];
+	size_t len = 0;
+	model[0] = '\0';
+
+	// take the first occurrence of each key, as the first core stands for all
+	for (size_t k = 0; k < sizeof(key) / sizeof(key[0]); ++k) {
+		std::rewind(f);
+
+		while (std::fgets(line, sizeof(line), f)) {
+			if (std::strncmp(line, key[k], std::strlen(key[k])))
+				continue;
+
+			const char* const value = std::strchr(line, ':');
+
+			if (0 == value)
+				continue;
+
+			const int printed = std::snprintf(model + len, size - len, "%s%s", len ? " " : "", value + 2);
+
+			if (0 < printed)
+				len = len + size_t(printed) < size ? len + size_t(printed) : size - 1;
+
+			// drop the line end
+			if (len && '\n' == model[len - 1])
+				model[--len] = '\0';
+
+			break;
+		}
+	}
+
+	std::fclose(f);
+	return 0 != len;
+}
+
+// get the path of the engine cache into path: the user's home directory, or the current one; return false on failure
+static bool getCachePath(
+	char* const path,
+	const size_t size) {
+
+	const char* const home = std::getenv("HOME");
+	const int printed = home
+		? std::snprintf(path, size, "%s/%s", home, engine_cache)
+		: std::snprintf(path, size, "%s", engine_cache);
+
+	return 0 < printed && size_t(printed) < size;
+}
+
+// look the CPU model up in the engine cache; return engine_count if not cached
+static size_t lookupEngine(
+	const char* const path,
+	const char* const model) {
+
+	FILE* const f = std::fopen(path, "r");
+
+	if (0 == f)
+		return engine_count;
+
+	char line[512];
+	size_t engine = engine_count;
+
+	// cache lines go as: engine_name <tab> cpu_model; later lines override earlier ones
+	while (std::fgets(line, sizeof(line), f)) {
+		char* const tab = std::strchr(line, '\t');
+
+		if (0 == tab)
+			continue;
+
+		*tab = '\0';
+		char* const end = std::strchr(tab + 1, '\n');
+
+		if (0 != end)
+			*end = '\0';
+
+		if (!std::strcmp(tab + 1, model) && engine_count != findEngine(line))
+			engine = findEngine(line);
+	}
+
+	std::fclose(f);
+	return engine;
+}
+
+// add the engine of the CPU model to the engine cache
+static void storeEngine(
+	const char* const path,
+	const char* const model,
+	const size_t engine) {
+
+	stream::out cache;
+
+	if (!cache.open(path)) {
+		stream::cerr << "failed to open engine cache '" << path << "'\n";
+		return;
+	}
+
+	cache << engine_name[engine] << '\t' << model << '\n';
+}
+
+// monotonic time in nanoseconds
+static uint64_t getTime() {
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return uint64_t(t.tv_sec) * 1000000000 + uint64_t(t.tv_nsec);
+}
+
+// run the calibration program on every engine, best of several runs each; return the fastest engine, or
+// engine_count on failure
+static size_t calibrate(const char* const argv0) {
+	char filename[] = "/tmp/brinterp_calibration_XXXXXX";
+	const int fd = mkstemp(filename);
+
+	if (-1 == fd)
+		return engine_count;
+
+	const ssize_t len = sizeof(calibration_source) - 1;
+	const bool written = len == write(fd, calibration_source, len);
+	close(fd);
+
+	size_t best = engine_count;
+	uint64_t bestTime = uint64_t(-1);
+
+	for (size_t i = 0; i < engine_count && written; ++i)
+		for (size_t r = 0; r < calibration_runs; ++r) {
+			char* argv[] = { const_cast< char* >(argv0), filename, 0 };
+			const uint64_t start = getTime();
+
+			if (0 != engine_main[i](2, argv)) {
+				r = calibration_runs;
+				continue;
+			}
+
+			const uint64_t time = getTime() - start;
+
+			if (time < bestTime) {
+				bestTime = time;
+				best = i;
+			}
+		}
+
+	unlink(filename);
+	return best;
+}
+
+// pick the engine for this host: the cached one for its CPU model, or else the calibration winner, which
+// gets cached in turn; return engine_count on failure
+static size_t pickEngine(const char* const argv0) {
+	char model[256];
+	char path[1024];
+
+	if (!getCpuModel(model, sizeof(model)))
+		std::strcpy(model, "unknown");
+
+	const bool cached = getCachePath(path, sizeof(path));
+
+	if (cached) {
+		const size_t engine = lookupEngine(path, model);
+
+		if (engine_count != engine)
+			return engine;
+	}
+
+	const size_t engine = calibrate(argv0);
+
+	if (cached && engine_count != engine)
+		storeEngine(path, model, engine);
+
+	return engine;
+}
+
+int main(
+	int argc,
+	char** argv) {
+
+	stream::cin.open(stdin);
+	stream::cout.open(stdout);
+	stream::cerr.open(stderr);
+
+	size_t engine = 0;
+
+	// strip the engine option off the args; the rest goes to the engine itself
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], arg_engine))
+			continue;
+
+		if (i + 1 == argc) {
+			engine = engine_count;
+			break;
+		}
+
+		const char* const name = argv[i + 1];
+		engine = std::strcmp(name, engine_auto) ? findEngine(name) : pickEngine(argv[0]);
+
+		if (engine_count == engine) {
+			if (std::strcmp(name, engine_auto))
+				break;
+
+			stream::cerr << "failed to calibrate engines; using " << engine_name[0] << '\n';
+			engine = 0;
+		}
+
+		for (int j = i + 2; j < argc; ++j)
+			argv[j - 2] = argv[j];
+
+		argc -= 2;
+		argv[argc] = 0;
+		break;
+	}
+
+	if (engine_count == engine) {
+		stream::cerr << "usage: " << argv[0] << " [" << arg_engine << " <engine>] [<option> ...] <source_filename>\n"
+			"engines: " << engine_auto;
+
+		for (size_t i = 0; i < engine_count; ++i)
+			stream::cerr << ", " << engine_name[i];
+
+		stream::cerr << "; default is " << engine_name[0] << "; " << engine_auto << " picks the fastest one on this CPU model, as cached in ~/" << engine_cache << '\n';
+		return 1;
+	}
+
+	return engine_main[engine](argc, argv);
+}
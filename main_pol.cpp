@@ -0,0 +1,338 @@
+#define NIBBLE_OPCODE 1
+#ifndef FIXED_POLICY
+#define POLICY_OPTION 1
+
+#endif
+#include "frontend.hpp"
+
+// interpreter-loop policy: each knob is independent of the others, and every combination of them gets
+// instantiated; knobs go as bits of the policy index
+template < bool CACHE_CELL, bool BRANCHLESS_COND, bool ASSUME_OPCODE >
+struct Policy {
+	static const bool cache_cell = CACHE_CELL;           // keep the current word in a register, as alt
+	static const bool branchless_cond = BRANCHLESS_COND; // take branches by masking their offsets, as alt
+	static const bool assume_opcode = ASSUME_OPCODE;     // let the compiler assume the opcode range, as alt-alt
+};
+
+enum {
+	POLICY_CACHE_CELL      = 1,
+	POLICY_BRANCHLESS_COND = 2,
+	POLICY_ASSUME_OPCODE   = 4,
+
+	POLICY_COUNT           = 8,
+
+#ifdef FIXED_POLICY
+	POLICY_DEFAULT         = FIXED_POLICY // as the version which fixes it has it
+
+#else
+	POLICY_DEFAULT         = POLICY_CACHE_CELL | POLICY_BRANCHLESS_COND // as alt
+
+#endif
+};
+
+template < size_t INDEX >
+struct PolicyOf {
+	typedef Policy<
+		0 != (INDEX & POLICY_CACHE_CELL),
+		0 != (INDEX & POLICY_BRANCHLESS_COND),
+		0 != (INDEX & POLICY_ASSUME_OPCODE) > type;
+};
+
+// current word, either cached in a register, or kept in memory
+template < bool CACHE_CELL >
+class Cell;
+
+template <>
+class Cell< true > {
+	word_t cell;
+
+public:
+	Cell(const word_t* const mem, const size_t dp)
+	: cell(mem[dp]) {
+	}
+
+	word_t get(const word_t*, const size_t) const {
+		return cell;
+	}
+
+	void set(word_t*, const size_t, const word_t word) {
+		cell = word;
+	}
+
+	// write the cached word back ahead of a data-pointer move
+	void spill(word_t* const mem, const size_t dp) const {
+		mem[dp] = cell;
+	}
+
+	// reload the cached word past a data-pointer move
+	void fill(const word_t* const mem, const size_t dp) {
+		cell = mem[dp];
+	}
+};
+
+template <>
+class Cell< false > {
+public:
+	Cell(const word_t*, const size_t) {
+	}
+
+	word_t get(const word_t* const mem, const size_t dp) const {
+		return mem[dp];
+	}
+
+	void set(word_t* const mem, const size_t dp, const word_t word) {
+		mem[dp] = word;
+	}
+
+	void spill(word_t*, const size_t) const {
+	}
+
+	void fill(const word_t*, const size_t) {
+	}
+};
+
+// offset of a branch taken if the word is zero, or not, as the policy has it
+template < typename POLICY >
+static size_t branchOffset(
+	const word_t word,
+	const bool ifZero,
+	const size_t offset) {
+
+	if (POLICY::branchless_cond) {
+		const size_t word_mask = word ? -1 : 0;
+		return offset & (ifZero ? ~word_mask : word_mask);
+	}
+
+	return (0 == word) == ifZero ? offset : 0;
+}
+
+// let the compiler assume the opcode range, as the policy has it
+template < typename POLICY >
+static void assumeOpcode(const uint32_t op) {
+	if (!POLICY::assume_opcode)
+		return;
+
+#if __clang_major__ > 3 || __clang_major__ == 3 && __clang_minor__ >= 6
+	__builtin_assume(op < 16);
+
+#else
+	if (op >= 16)
+		__builtin_unreachable();
+
+#endif
+}
+
+// run a program of either command form off code, with the data memory right past the program, by the given policy
+template < typename POLICY, typename COMMAND_T >
+static int run(
+	const COMMAND_T* const code,
+	const size_t programLength,
+	const size_t dataLength,
+	const uint64_t terminalCount,
+	const bool print_ascii) {
+
+	const Ptr< const COMMAND_T > program(code);
+	const AlignedPtr< word_t, cacheline_size > mem(uintptr_t(code + programLength) + fold_range * sizeof(word_t));
+
+	uint64_t count = 0;
+	size_t ip = 0;
+	size_t dp = 0;
+	Cell< POLICY::cache_cell > cell(mem(), dp);
+
+#if ENABLE_DIAGNOSTICS
+	while (count < terminalCount &&
+		   ip < programLength &&
+		   dp < dataLength) {
+
+#else
+	(void) terminalCount;
+
+	while (ip < programLength) {
+
+#endif
+		const COMMAND_T cmd = program()[ip];
+		const uint32_t op = cmd.getOp();
+		int input;
+
+		assumeOpcode< POLICY >(op);
+
+		switch (op) {
+		case OPCODE_ADD_WORD:
+			cell.set(mem(), dp, cell.get(mem(), dp) + word_t(cmd.getImm()));
+			break;
+		case OPCODE_SET_WORD:
+			cell.set(mem(), dp, word_t(cmd.getImm()));
+			break;
+		case OPCODE_MUL_ADD:
+
+#if ENABLE_DIAGNOSTICS
+			if (0 != cell.get(mem(), dp) && dp + program()[ip + 1].getDisp() >= dataLength) {
+				cell.spill(mem(), dp);
+				dp += program()[ip + 1].getDisp();
+				break;
+			}
+
+#endif
+			++ip;
+			mem()[dp + program()[ip].getDisp()] += cell.get(mem(), dp) * program()[ip].getValue();
+			break;
+		case OPCODE_ADD_PTR:
+			cell.spill(mem(), dp);
+			dp += cmd.getImm();
+			cell.fill(mem(), dp);
+			break;
+		case OPCODE_SUB_PTR:
+			cell.spill(mem(), dp);
+			dp -= cmd.getImm();
+			cell.fill(mem(), dp);
+			break;
+		case OPCODE_COND_L:
+			ip += branchOffset< POLICY >(cell.get(mem(), dp), true, cmd.getImm());
+			break;
+		case OPCODE_COND_R:
+			ip -= branchOffset< POLICY >(cell.get(mem(), dp), false, cmd.getImm());
+			break;
+		case OPCODE_SCAN:
+			cell.spill(mem(), dp);
+			++ip;
+			if (0 < program()[ip].getDisp())
+				dp = scan::seek_zero_fwd(mem(), dataLength, dp, size_t(program()[ip].getDisp()));
+			else
+				dp = scan::seek_zero_rev(mem(), dataLength, dp, size_t(-program()[ip].getDisp()));
+			cell.fill(mem(), dp);
+			break;
+		case OPCODE_INPUT:
+			stream::cin >> input;
+			cell.set(mem(), dp, word_t(input));
+			break;
+		case OPCODE_OUTPUT:
+			print(cell.get(mem(), dp), print_ascii);
+			break;
+		case OPCODE_ADD_WORD_AT:
+
+#if ENABLE_DIAGNOSTICS
+			if (dp + program()[ip + 1].getDisp() >= dataLength) {
+				cell.spill(mem(), dp);
+				dp += program()[ip + 1].getDisp();
+				break;
+			}
+
+#endif
+			++ip;
+			mem()[dp + program()[ip].getDisp()] += program()[ip].getValue();
+			break;
+		case OPCODE_INPUT_AT:
+
+#if ENABLE_DIAGNOSTICS
+			if (dp + program()[ip + 1].getDisp() >= dataLength) {
+				cell.spill(mem(), dp);
+				dp += program()[ip + 1].getDisp();
+				break;
+			}
+
+#endif
+			++ip;
+			stream::cin >> input;
+			mem()[dp + program()[ip].getDisp()] = word_t(input);
+			break;
+		case OPCODE_OUTPUT_AT:
+
+#if ENABLE_DIAGNOSTICS
+			if (dp + program()[ip + 1].getDisp() >= dataLength) {
+				cell.spill(mem(), dp);
+				dp += program()[ip + 1].getDisp();
+				break;
+			}
+
+#endif
+			++ip;
+			print(mem()[dp + program()[ip].getDisp()], print_ascii);
+			break;
+		}
+
+		++ip;
+		++count;
+	}
+
+#if ENABLE_DIAGNOSTICS
+	if (dp >= dataLength) {
+		stream::cerr << "program error: out-of-bounds data pointer at ip " << ip - 1 << '\n';
+		return -1;
+	}
+
+	stream::cout << "\ninstructions executed: " << count << '\n';
+
+#endif
+	return 0;
+}
+
+// run a program of either command form by the policy of the given index; versions which fix the policy at
+// build time instantiate just that one
+template < typename COMMAND_T >
+static int run(
+	const size_t policy,
+	const COMMAND_T* const code,
+	const size_t programLength,
+	const size_t dataLength,
+	const uint64_t terminalCount,
+	const bool print_ascii) {
+
+#ifdef FIXED_POLICY
+	(void) policy;
+	return run< typename PolicyOf< FIXED_POLICY >::type, COMMAND_T >(code, programLength, dataLength, terminalCount, print_ascii);
+
+#else
+	typedef int (*run_t)(const COMMAND_T*, size_t, size_t, uint64_t, bool);
+
+	static const run_t instance[POLICY_COUNT] = {
+		run< typename PolicyOf< 0 >::type, COMMAND_T >,
+		run< typename PolicyOf< 1 >::type, COMMAND_T >,
+		run< typename PolicyOf< 2 >::type, COMMAND_T >,
+		run< typename PolicyOf< 3 >::type, COMMAND_T >,
+		run< typename PolicyOf< 4 >::type, COMMAND_T >,
+		run< typename PolicyOf< 5 >::type, COMMAND_T >,
+		run< typename PolicyOf< 6 >::type, COMMAND_T >,
+		run< typename PolicyOf< 7 >::type, COMMAND_T >
+	};
+
+	const compile_assert< POLICY_COUNT == sizeof(instance) / sizeof(instance[0]) > assert_instance_count;
+	(void) assert_instance_count;
+
+	return instance[policy](code, programLength, dataLength, terminalCount, print_ascii);
+
+#endif
+}
+
+// run the compact form of the program whenever that fits, for its cache density, by the policy the command
+// line picks, if it may
+static int interpret(
+	const Command32* const wide,
+	const size_t programLength,
+	void* const space,
+	const size_t dataLength,
+	const cli_param& param) {
+
+	const bool print_ascii = bool(param.flags & cli_param::FLAG_PRINT_ASCII);
+
+#if POLICY_OPTION
+	const size_t policy = param.flags & cli_param::FLAG_POLICY ? size_t(param.policy) : size_t(POLICY_DEFAULT);
+
+	if (POLICY_COUNT <= policy) {
+		stream::cerr << "policy index out of range\n";
+		return 1;
+	}
+
+#else
+	const size_t policy = POLICY_DEFAULT;
+
+#endif
+	const AlignedPtr< Command16, mempage_size > code16((uintptr_t(space)));
+
+	if (narrow(wide, programLength, code16()))
+		return run(policy, code16(), programLength, dataLength, param.terminalCount, print_ascii);
+
+	const AlignedPtr< Command32, mempage_size > code32((uintptr_t(space)));
+	std::memcpy(code32(), wide, programLength * sizeof(Command32));
+
+	return run(policy, code32(), programLength, dataLength, param.terminalCount, print_ascii);
+}
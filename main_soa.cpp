@@ -0,0 +1,273 @@
+#define SPLIT_PROGRAM 1
+#define CODE_SPACE(length) ((length) * (sizeof(uint8_t) + sizeof(int32_t)) + cacheline_size) // opcode and immediate streams, the latter aligned
+#include "frontend.hpp"
+
+// opcode of the structure-of-arrays form of a program: one byte per op, with the immediates of the ops,
+// if any, in a parallel array of their own
+enum SoaOpcode {
+	SOA_ADD_WORD,    // immediate: addend
+	SOA_SET_WORD,    // immediate: word
+	SOA_MOVE_PTR,    // immediate: signed displacement
+	SOA_COND_L,      // immediate: absolute index of the matching SOA_COND_R
+	SOA_COND_R,      // immediate: absolute index of the matching SOA_COND_L
+	SOA_INPUT,
+	SOA_OUTPUT,
+	SOA_MUL_ADD,     // immediate: displacement in the low byte, factor above that
+	SOA_SCAN,        // immediate: signed stride
+	SOA_ADD_WORD_AT, // immediate: displacement in the low byte, addend above that
+	SOA_INPUT_AT,    // immediate: displacement
+	SOA_OUTPUT_AT    // immediate: displacement
+};
+
+// pack a displacement and a word into an immediate of the structure-of-arrays form
+static int32_t packOperand(
+	const int8_t disp,
+	const word_t value) {
+
+	return int32_t(uint8_t(disp)) | int32_t(value) << 8;
+}
+
+// split a translated program to its structure-of-arrays form: a dense opcode array at op, and a parallel
+// immediate array at imm; operand words fold into the immediates of their ops; return the length of the
+// split program, or 0 if the index remap cannot be provided
+static size_t split(
+	const Command32* const wide,
+	const size_t programLength,
+	uint8_t* const op,
+	int32_t* const imm) {
+
+	using testbed::scoped_ptr;
+
+	// map every command of the translated program to its index in the split one
+	const scoped_ptr< size_t, generic_free > remap(
+		reinterpret_cast< size_t* >(std::calloc(programLength + 1, sizeof(size_t))));
+
+	if (0 == remap())
+		return 0;
+
+	size_t j = 0;
+
+	for (size_t i = 0; i < programLength; ++i, ++j) {
+		remap()[i] = j;
+
+		if (wide[i].hasOperand())
+			remap()[++i] = j;
+	}
+
+	j = 0;
+
+	for (size_t i = 0; i < programLength; ++i, ++j) {
+		const Command32 cmd = wide[i];
+
+		switch (cmd.getOp()) {
+		case OPCODE_ADD_WORD:
+			op[j] = SOA_ADD_WORD;
+			imm[j] = int32_t(word_t(cmd.getArith()));
+			break;
+		case OPCODE_SET_WORD:
+			op[j] = SOA_SET_WORD;
+			imm[j] = int32_t(word_t(cmd.getOffset()));
+			break;
+		case OPCODE_ADD_PTR:
+			op[j] = SOA_MOVE_PTR;
+			imm[j] = int32_t(cmd.getArith());
+			break;
+		case OPCODE_SUB_PTR:
+			op[j] = SOA_MOVE_PTR;
+			imm[j] = -int32_t(cmd.getArith());
+			break;
+		case OPCODE_COND_L:
+			op[j] = SOA_COND_L;
+			imm[j] = int32_t(remap()[i + cmd.getOffset()]);
+			break;
+		case OPCODE_COND_R:
+			op[j] = SOA_COND_R;
+			imm[j] = int32_t(remap()[i - cmd.getOffset()]);
+			break;
+		case OPCODE_INPUT:
+			op[j] = SOA_INPUT;
+			break;
+		case OPCODE_OUTPUT:
+			op[j] = SOA_OUTPUT;
+			break;
+		case OPCODE_MUL_ADD:
+			op[j] = SOA_MUL_ADD;
+			++i;
+			imm[j] = packOperand(wide[i].getDisp(), wide[i].getValue());
+			break;
+		case OPCODE_SCAN:
+			op[j] = SOA_SCAN;
+			imm[j] = int32_t(wide[++i].getDisp());
+			break;
+		case OPCODE_ADD_WORD_AT:
+			op[j] = SOA_ADD_WORD_AT;
+			++i;
+			imm[j] = packOperand(wide[i].getDisp(), wide[i].getValue());
+			break;
+		case OPCODE_INPUT_AT:
+			op[j] = SOA_INPUT_AT;
+			imm[j] = int32_t(wide[++i].getDisp());
+			break;
+		case OPCODE_OUTPUT_AT:
+			op[j] = SOA_OUTPUT_AT;
+			imm[j] = int32_t(wide[++i].getDisp());
+			break;
+		}
+	}
+
+	return j;
+}
+
+// displacement of a packed immediate
+static ptrdiff_t getDisp(const int32_t imm) {
+	return int8_t(imm);
+}
+
+// word of a packed immediate
+static word_t getValue(const int32_t imm) {
+	return word_t(imm >> 8);
+}
+
+// run a program of structure-of-arrays form off op and imm, with the data memory right past the immediates;
+// dispatch takes a single byte load, and only the ops which have immediates load them
+static int run(
+	const uint8_t* const op,
+	const int32_t* const imm,
+	const size_t programLength,
+	const size_t dataLength,
+	const uint64_t terminalCount,
+	const bool print_ascii) {
+
+	const AlignedPtr< word_t, cacheline_size > mem(uintptr_t(imm + programLength) + fold_range * sizeof(word_t));
+
+	uint64_t count = 0;
+	size_t ip = 0;
+	size_t dp = 0;
+
+#if ENABLE_DIAGNOSTICS
+	while (count < terminalCount &&
+		   ip < programLength &&
+		   dp < dataLength) {
+
+#else
+	(void) terminalCount;
+
+	while (ip < programLength) {
+
+#endif
+		int input;
+
+		switch (op[ip]) {
+		case SOA_ADD_WORD:
+			mem()[dp] += word_t(imm[ip]);
+			break;
+		case SOA_SET_WORD:
+			mem()[dp] = word_t(imm[ip]);
+			break;
+		case SOA_MUL_ADD:
+
+#if ENABLE_DIAGNOSTICS
+			if (0 != mem()[dp] && dp + getDisp(imm[ip]) >= dataLength) {
+				dp += getDisp(imm[ip]);
+				break;
+			}
+
+#endif
+			mem()[dp + getDisp(imm[ip])] += mem()[dp] * getValue(imm[ip]);
+			break;
+		case SOA_SCAN:
+			if (0 < imm[ip])
+				dp = scan::seek_zero_fwd(mem(), dataLength, dp, size_t(imm[ip]));
+			else
+				dp = scan::seek_zero_rev(mem(), dataLength, dp, size_t(-imm[ip]));
+			break;
+		case SOA_INPUT:
+			stream::cin >> input;
+			mem()[dp] = word_t(input);
+			break;
+		case SOA_OUTPUT:
+			print(mem()[dp], print_ascii);
+			break;
+		case SOA_ADD_WORD_AT:
+
+#if ENABLE_DIAGNOSTICS
+			if (dp + getDisp(imm[ip]) >= dataLength) {
+				dp += getDisp(imm[ip]);
+				break;
+			}
+
+#endif
+			mem()[dp + getDisp(imm[ip])] += getValue(imm[ip]);
+			break;
+		case SOA_INPUT_AT:
+
+#if ENABLE_DIAGNOSTICS
+			if (dp + imm[ip] >= dataLength) {
+				dp += imm[ip];
+				break;
+			}
+
+#endif
+			stream::cin >> input;
+			mem()[dp + imm[ip]] = word_t(input);
+			break;
+		case SOA_OUTPUT_AT:
+
+#if ENABLE_DIAGNOSTICS
+			if (dp + imm[ip] >= dataLength) {
+				dp += imm[ip];
+				break;
+			}
+
+#endif
+			print(mem()[dp + imm[ip]], print_ascii);
+			break;
+		case SOA_COND_L:
+			if (0 == mem()[dp])
+				ip = size_t(imm[ip]);
+			break;
+		case SOA_COND_R:
+			if (0 != mem()[dp])
+				ip = size_t(imm[ip]);
+			break;
+		case SOA_MOVE_PTR:
+			dp += imm[ip];
+			break;
+		}
+
+		++ip;
+		++count;
+	}
+
+#if ENABLE_DIAGNOSTICS
+	if (dp >= dataLength) {
+		stream::cerr << "program error: out-of-bounds data pointer at ip " << ip - 1 << '\n';
+		return -1;
+	}
+
+	stream::cout << "\ninstructions executed: " << count << '\n';
+
+#endif
+	return 0;
+}
+
+// split the program to its opcode and immediate streams, right past one another in the code region, and run that
+static int interpret(
+	const Command32* const wide,
+	const size_t programLength,
+	void* const space,
+	const size_t dataLength,
+	const cli_param& param) {
+
+	const bool print_ascii = bool(param.flags & cli_param::FLAG_PRINT_ASCII);
+	const AlignedPtr< uint8_t, mempage_size > op((uintptr_t(space)));
+	const AlignedPtr< int32_t, cacheline_size > imm(uintptr_t(op() + programLength));
+	const size_t splitLength = split(wide, programLength, op(), imm());
+
+	if (0 == splitLength && 0 != programLength) {
+		stream::cerr << "failed to split program\n";
+		return -1;
+	}
+
+	return run(op(), imm(), splitLength, dataLength, param.terminalCount, print_ascii);
+}
@@ -0,0 +1,329 @@
+#include "frontend.hpp"
+
+#if defined(__has_attribute)
+#if __has_attribute(musttail)
+#define HAS_MUSTTAIL 1
+
+#endif
+#endif
+#if HAS_MUSTTAIL
+#define MUSTTAIL __attribute__ ((musttail))
+
+#else
+// without musttail, the tail calls are up to the sibling-call optimization of the compiler; build.sh
+// builds thr in place of this version then
+#define MUSTTAIL
+
+#endif
+struct Tail;
+struct Context;
+
+// tail-call-threaded handler: the program position, the data memory, the data pointer and the cached
+// current word all travel in argument registers, from one handler to the next
+typedef void (*handler_t)(const Tail* ip, word_t* mem, size_t dp, word_t cell, Context* ctx);
+
+// tail-call-threaded program entry: handler and its immediate, one per command word
+struct Tail {
+	handler_t handler;
+	ptrdiff_t imm;
+};
+
+// state of the run that does not get along in registers
+struct Context {
+	size_t dataLength;
+	bool print_ascii;
+
+#if ENABLE_DIAGNOSTICS
+	uint64_t terminalCount;
+	uint64_t count;
+	const Tail* ip;
+	size_t dp;
+
+#endif
+};
+
+// decode the operand word following the tail-call-threaded op at t: displacement goes with the op, value with the operand
+template < typename COMMAND_T >
+static void decodeOperand(
+	Tail* const t,
+	const COMMAND_T operand) {
+
+	t[0].imm = operand.getDisp();
+	t[1].imm = operand.getValue();
+}
+
+#if ENABLE_DIAGNOSTICS
+#define DISPATCH(step)                                                       \
+	do {                                                                     \
+		ip += step;                                                          \
+		if (++ctx->count == ctx->terminalCount || dp >= ctx->dataLength) {   \
+			ctx->ip = ip;                                                    \
+			ctx->dp = dp;                                                    \
+			return;                                                          \
+		}                                                                    \
+		MUSTTAIL return ip->handler(ip, mem, dp, cell, ctx);                 \
+	} while (0)
+
+#else
+#define DISPATCH(step)                                                       \
+	do {                                                                     \
+		ip += step;                                                          \
+		MUSTTAIL return ip->handler(ip, mem, dp, cell, ctx);                 \
+	} while (0)
+
+#endif
+// read a word off the input; that keeps the handlers free of locals whose address gets taken, as musttail
+// requires
+static word_t __attribute__ ((noinline)) input() {
+	int word;
+	stream::cin >> word;
+	return word_t(word);
+}
+
+#define HANDLER(name) \
+static void name(const Tail* ip, word_t* const mem, size_t dp, word_t cell, Context* const ctx)
+
+HANDLER(opAddWord) {
+	cell += word_t(ip->imm);
+	DISPATCH(1);
+}
+
+HANDLER(opSetWord) {
+	cell = word_t(ip->imm);
+	DISPATCH(1);
+}
+
+HANDLER(opMulAdd) {
+
+#if ENABLE_DIAGNOSTICS
+	if (0 != cell && dp + ip->imm >= ctx->dataLength) {
+		dp += ip->imm;
+		DISPATCH(1);
+	}
+
+#endif
+	mem[dp + ip->imm] += cell * word_t(ip[1].imm);
+	DISPATCH(2);
+}
+
+HANDLER(opScan) {
+	mem[dp] = cell;
+	if (0 < ip->imm)
+		dp = scan::seek_zero_fwd(mem, ctx->dataLength, dp, size_t(ip->imm));
+	else
+		dp = scan::seek_zero_rev(mem, ctx->dataLength, dp, size_t(-ip->imm));
+	cell = mem[dp];
+	DISPATCH(2);
+}
+
+HANDLER(opInput) {
+	cell = input();
+	DISPATCH(1);
+}
+
+HANDLER(opOutput) {
+	print(cell, ctx->print_ascii);
+	DISPATCH(1);
+}
+
+HANDLER(opAddWordAt) {
+
+#if ENABLE_DIAGNOSTICS
+	if (dp + ip->imm >= ctx->dataLength) {
+		dp += ip->imm;
+		DISPATCH(1);
+	}
+
+#endif
+	mem[dp + ip->imm] += word_t(ip[1].imm);
+	DISPATCH(2);
+}
+
+HANDLER(opInputAt) {
+
+#if ENABLE_DIAGNOSTICS
+	if (dp + ip->imm >= ctx->dataLength) {
+		dp += ip->imm;
+		DISPATCH(1);
+	}
+
+#endif
+	mem[dp + ip->imm] = input();
+	DISPATCH(2);
+}
+
+HANDLER(opOutputAt) {
+
+#if ENABLE_DIAGNOSTICS
+	if (dp + ip->imm >= ctx->dataLength) {
+		dp += ip->imm;
+		DISPATCH(1);
+	}
+
+#endif
+	print(mem[dp + ip->imm], ctx->print_ascii);
+	DISPATCH(2);
+}
+
+HANDLER(opCondL) {
+	if (0 == cell)
+		ip += ip->imm;
+	DISPATCH(1);
+}
+
+HANDLER(opCondR) {
+	if (0 != cell)
+		ip += ip->imm;
+	DISPATCH(1);
+}
+
+HANDLER(opMovePtr) {
+	mem[dp] = cell;
+	dp += ip->imm;
+	cell = mem[dp];
+	DISPATCH(1);
+}
+
+HANDLER(opEnd) {
+	(void) ip;
+	(void) mem;
+	(void) dp;
+	(void) cell;
+	(void) ctx;
+}
+
+#undef HANDLER
+#undef DISPATCH
+#undef MUSTTAIL
+
+// run a program of either command form off code, with the data memory right past the program; the
+// program gets pre-decoded to handler functions, each of which tail-calls the next one
+template < typename COMMAND_T >
+static int run(
+	const COMMAND_T* const code,
+	const size_t programLength,
+	const size_t dataLength,
+	const uint64_t terminalCount,
+	const bool print_ascii) {
+
+	using testbed::scoped_ptr;
+
+	const Ptr< const COMMAND_T > program(code);
+	const AlignedPtr< word_t, cacheline_size > mem(uintptr_t(code + programLength) + fold_range * sizeof(word_t));
+
+	const scoped_ptr< Tail, generic_free > threaded(
+		reinterpret_cast< Tail* >(std::calloc(programLength + 1, sizeof(Tail))));
+
+	if (0 == threaded()) {
+		stream::cerr << "failed to provide threaded program memory\n";
+		return -1;
+	}
+
+	// operand words keep their entries, so branch offsets carry over as they are
+	for (size_t i = 0; i < programLength; ++i) {
+		const COMMAND_T cmd = program()[i];
+		Tail& t = threaded()[i];
+
+		switch (cmd.getOp()) {
+		case OPCODE_ADD_WORD:
+			t.handler = opAddWord;
+			t.imm = ptrdiff_t(word_t(cmd.getArith()));
+			break;
+		case OPCODE_SET_WORD:
+			t.handler = opSetWord;
+			t.imm = ptrdiff_t(word_t(cmd.getOffset()));
+			break;
+		case OPCODE_ADD_PTR:
+			t.handler = opMovePtr;
+			t.imm = ptrdiff_t(cmd.getArith());
+			break;
+		case OPCODE_SUB_PTR:
+			t.handler = opMovePtr;
+			t.imm = -ptrdiff_t(cmd.getArith());
+			break;
+		case OPCODE_COND_L:
+			t.handler = opCondL;
+			t.imm = ptrdiff_t(cmd.getOffset());
+			break;
+		case OPCODE_COND_R:
+			t.handler = opCondR;
+			t.imm = -ptrdiff_t(cmd.getOffset());
+			break;
+		case OPCODE_INPUT:
+			t.handler = opInput;
+			break;
+		case OPCODE_OUTPUT:
+			t.handler = opOutput;
+			break;
+		case OPCODE_MUL_ADD:
+			t.handler = opMulAdd;
+			decodeOperand(&t, program()[++i]);
+			break;
+		case OPCODE_SCAN:
+			t.handler = opScan;
+			decodeOperand(&t, program()[++i]);
+			break;
+		case OPCODE_ADD_WORD_AT:
+			t.handler = opAddWordAt;
+			decodeOperand(&t, program()[++i]);
+			break;
+		case OPCODE_INPUT_AT:
+			t.handler = opInputAt;
+			decodeOperand(&t, program()[++i]);
+			break;
+		case OPCODE_OUTPUT_AT:
+			t.handler = opOutputAt;
+			decodeOperand(&t, program()[++i]);
+			break;
+		}
+	}
+
+	threaded()[programLength].handler = opEnd;
+
+	Context ctx;
+	ctx.dataLength = dataLength;
+	ctx.print_ascii = print_ascii;
+
+#if ENABLE_DIAGNOSTICS
+	ctx.terminalCount = terminalCount;
+	ctx.count = 0;
+	ctx.ip = threaded();
+	ctx.dp = 0;
+
+	if (0 != terminalCount)
+		threaded()->handler(threaded(), mem(), 0, mem()[0], &ctx);
+
+	if (ctx.dp >= dataLength) {
+		stream::cerr << "program error: out-of-bounds data pointer at ip " << ctx.ip - threaded() - 1 << '\n';
+		return -1;
+	}
+
+	stream::cout << "\ninstructions executed: " << ctx.count << '\n';
+
+#else
+	(void) terminalCount;
+	threaded()->handler(threaded(), mem(), 0, mem()[0], &ctx);
+
+#endif
+	return 0;
+}
+
+// run the compact form of the program whenever that fits, for its cache density
+static int interpret(
+	const Command32* const wide,
+	const size_t programLength,
+	void* const space,
+	const size_t dataLength,
+	const cli_param& param) {
+
+	const bool print_ascii = bool(param.flags & cli_param::FLAG_PRINT_ASCII);
+	const AlignedPtr< Command16, mempage_size > code16((uintptr_t(space)));
+
+	if (narrow(wide, programLength, code16()))
+		return run(code16(), programLength, dataLength, param.terminalCount, print_ascii);
+
+	const AlignedPtr< Command32, mempage_size > code32((uintptr_t(space)));
+	std::memcpy(code32(), wide, programLength * sizeof(Command32));
+
+	return run(code32(), programLength, dataLength, param.terminalCount, print_ascii);
+}
@@ -0,0 +1,258 @@
+#include "frontend.hpp"
+
+// threaded program entry: handler address and its immediate, one per command word
+struct Thread {
+	const void* handler;
+	ptrdiff_t imm;
+};
+
+// decode the operand word following the threaded op at t: displacement goes with the op, value with the operand
+template < typename COMMAND_T >
+static void decodeOperand(
+	Thread* const t,
+	const COMMAND_T operand) {
+
+	t[0].imm = operand.getDisp();
+	t[1].imm = operand.getValue();
+}
+
+#if ENABLE_DIAGNOSTICS
+#define DISPATCH(step)                                   \
+	do {                                                 \
+		thread += step;                                  \
+		if (++count == terminalCount || dp >= dataLength) \
+			goto done;                                   \
+		goto *thread->handler;                           \
+	} while (0)
+
+#else
+#define DISPATCH(step)                                   \
+	do {                                                 \
+		thread += step;                                  \
+		goto *thread->handler;                           \
+	} while (0)
+
+#endif
+// run a program of either command form off code, with the data memory right past the program; the
+// program gets pre-decoded to handler addresses, so each handler ends with its own indirect jump
+template < typename COMMAND_T >
+static int run(
+	const COMMAND_T* const code,
+	const size_t programLength,
+	const size_t dataLength,
+	const uint64_t terminalCount,
+	const bool print_ascii) {
+
+	using testbed::scoped_ptr;
+
+	const Ptr< const COMMAND_T > program(code);
+	const AlignedPtr< word_t, cacheline_size > mem(uintptr_t(code + programLength) + fold_range * sizeof(word_t));
+
+	const scoped_ptr< Thread, generic_free > threaded(
+		reinterpret_cast< Thread* >(std::calloc(programLength + 1, sizeof(Thread))));
+
+	if (0 == threaded()) {
+		stream::cerr << "failed to provide threaded program memory\n";
+		return -1;
+	}
+
+	// operand words keep their entries, so branch offsets carry over as they are
+	for (size_t i = 0; i < programLength; ++i) {
+		const COMMAND_T cmd = program()[i];
+		Thread& t = threaded()[i];
+
+		switch (cmd.getOp()) {
+		case OPCODE_ADD_WORD:
+			t.handler = &&op_add_word;
+			t.imm = ptrdiff_t(word_t(cmd.getArith()));
+			break;
+		case OPCODE_SET_WORD:
+			t.handler = &&op_set_word;
+			t.imm = ptrdiff_t(word_t(cmd.getOffset()));
+			break;
+		case OPCODE_ADD_PTR:
+			t.handler = &&op_move_ptr;
+			t.imm = ptrdiff_t(cmd.getArith());
+			break;
+		case OPCODE_SUB_PTR:
+			t.handler = &&op_move_ptr;
+			t.imm = -ptrdiff_t(cmd.getArith());
+			break;
+		case OPCODE_COND_L:
+			t.handler = &&op_cond_l;
+			t.imm = ptrdiff_t(cmd.getOffset());
+			break;
+		case OPCODE_COND_R:
+			t.handler = &&op_cond_r;
+			t.imm = -ptrdiff_t(cmd.getOffset());
+			break;
+		case OPCODE_INPUT:
+			t.handler = &&op_input;
+			break;
+		case OPCODE_OUTPUT:
+			t.handler = &&op_output;
+			break;
+		case OPCODE_MUL_ADD:
+			t.handler = &&op_mul_add;
+			decodeOperand(&t, program()[++i]);
+			break;
+		case OPCODE_SCAN:
+			t.handler = &&op_scan;
+			decodeOperand(&t, program()[++i]);
+			break;
+		case OPCODE_ADD_WORD_AT:
+			t.handler = &&op_add_word_at;
+			decodeOperand(&t, program()[++i]);
+			break;
+		case OPCODE_INPUT_AT:
+			t.handler = &&op_input_at;
+			decodeOperand(&t, program()[++i]);
+			break;
+		case OPCODE_OUTPUT_AT:
+			t.handler = &&op_output_at;
+			decodeOperand(&t, program()[++i]);
+			break;
+		}
+	}
+
+	threaded()[programLength].handler = &&op_end;
+
+	const Thread* thread = threaded();
+	uint64_t count = 0;
+	size_t dp = 0;
+	int input;
+
+#if ENABLE_DIAGNOSTICS
+	if (0 == terminalCount || dp >= dataLength)
+		goto done;
+
+#else
+	(void) terminalCount;
+
+#endif
+	goto *thread->handler;
+
+op_add_word:
+	mem()[dp] += word_t(thread->imm);
+	DISPATCH(1);
+
+op_set_word:
+	mem()[dp] = word_t(thread->imm);
+	DISPATCH(1);
+
+op_mul_add:
+
+#if ENABLE_DIAGNOSTICS
+	if (0 != mem()[dp] && dp + thread->imm >= dataLength) {
+		dp += thread->imm;
+		DISPATCH(1);
+	}
+
+#endif
+	mem()[dp + thread->imm] += mem()[dp] * word_t(thread[1].imm);
+	DISPATCH(2);
+
+op_scan:
+	if (0 < thread->imm)
+		dp = scan::seek_zero_fwd(mem(), dataLength, dp, size_t(thread->imm));
+	else
+		dp = scan::seek_zero_rev(mem(), dataLength, dp, size_t(-thread->imm));
+	DISPATCH(2);
+
+op_input:
+	stream::cin >> input;
+	mem()[dp] = word_t(input);
+	DISPATCH(1);
+
+op_output:
+	print(mem()[dp], print_ascii);
+	DISPATCH(1);
+
+op_add_word_at:
+
+#if ENABLE_DIAGNOSTICS
+	if (dp + thread->imm >= dataLength) {
+		dp += thread->imm;
+		DISPATCH(1);
+	}
+
+#endif
+	mem()[dp + thread->imm] += word_t(thread[1].imm);
+	DISPATCH(2);
+
+op_input_at:
+
+#if ENABLE_DIAGNOSTICS
+	if (dp + thread->imm >= dataLength) {
+		dp += thread->imm;
+		DISPATCH(1);
+	}
+
+#endif
+	stream::cin >> input;
+	mem()[dp + thread->imm] = word_t(input);
+	DISPATCH(2);
+
+op_output_at:
+
+#if ENABLE_DIAGNOSTICS
+	if (dp + thread->imm >= dataLength) {
+		dp += thread->imm;
+		DISPATCH(1);
+	}
+
+#endif
+	print(mem()[dp + thread->imm], print_ascii);
+	DISPATCH(2);
+
+op_cond_l:
+	if (0 == mem()[dp])
+		thread += thread->imm;
+	DISPATCH(1);
+
+op_cond_r:
+	if (0 != mem()[dp])
+		thread += thread->imm;
+	DISPATCH(1);
+
+op_move_ptr:
+	dp += thread->imm;
+	DISPATCH(1);
+
+op_end:
+
+#if ENABLE_DIAGNOSTICS
+done:
+	if (dp >= dataLength) {
+		stream::cerr << "program error: out-of-bounds data pointer at ip " << thread - threaded() - 1 << '\n';
+		return -1;
+	}
+
+	stream::cout << "\ninstructions executed: " << count << '\n';
+
+#endif
+	(void) count;
+	return 0;
+}
+
+#undef DISPATCH
+
+// run the compact form of the program whenever that fits, for its cache density
+static int interpret(
+	const Command32* const wide,
+	const size_t programLength,
+	void* const space,
+	const size_t dataLength,
+	const cli_param& param) {
+
+	const bool print_ascii = bool(param.flags & cli_param::FLAG_PRINT_ASCII);
+	const AlignedPtr< Command16, mempage_size > code16((uintptr_t(space)));
+
+	if (narrow(wide, programLength, code16()))
+		return run(code16(), programLength, dataLength, param.terminalCount, print_ascii);
+
+	const AlignedPtr< Command32, mempage_size > code32((uintptr_t(space)));
+	std::memcpy(code32(), wide, programLength * sizeof(Command32));
+
+	return run(code32(), programLength, dataLength, param.terminalCount, print_ascii);
+}
@@ -0,0 +1,445 @@
+#include "frontend.hpp"
+
+struct State;
+struct Closure;
+
+// pre-bound handler of a closure: it runs the op of the closure on the machine state at the given data
+// pointer, and returns the data pointer past the op; that keeps the data pointer in a register throughout
+typedef size_t (*handler_t)(State&, const Closure*, size_t);
+
+// closure-tree node: a handler with its immediates; a loop node holds the body of the loop -- a contiguous
+// run of closures ended by a null handler, so control structure never goes through a dispatch of its own
+struct Closure {
+	handler_t handler;
+	ptrdiff_t imm;
+	union {
+		ptrdiff_t value;
+		const Closure* body;
+	};
+
+#if ENABLE_DIAGNOSTICS
+	size_t ip;
+
+#endif
+};
+
+// machine state the closures run on
+struct State {
+	word_t* mem;
+	size_t dataLength;
+	bool print_ascii;
+
+#if ENABLE_DIAGNOSTICS
+	uint64_t terminalCount;
+	uint64_t count;
+	size_t ip;
+	bool halt;
+
+#endif
+};
+
+// retire a command at source position ip; return true if the machine should halt past it
+static inline bool retire(
+	State& s,
+	const size_t dp,
+	const size_t ip) {
+
+#if ENABLE_DIAGNOSTICS
+	s.ip = ip;
+	s.halt = ++s.count == s.terminalCount || dp >= s.dataLength;
+	return s.halt;
+
+#else
+	(void) s;
+	(void) dp;
+	(void) ip;
+	return false;
+
+#endif
+}
+
+// run the closures of a body in sequence, up to its null handler; return the data pointer past the body
+static inline size_t runBody(
+	State& s,
+	const Closure* c,
+	size_t dp) {
+
+	for (; 0 != c->handler; ++c) {
+		dp = c->handler(s, c, dp);
+
+#if ENABLE_DIAGNOSTICS
+		if (s.halt)
+			break;
+
+#endif
+	}
+
+	return dp;
+}
+
+#if ENABLE_DIAGNOSTICS
+// source position of a closure, for the sake of diagnostics
+#define CLOSURE_IP(c) (c)->ip
+
+#else
+#define CLOSURE_IP(c) ((void) (c), size_t(0))
+
+#endif
+static size_t opAddWord(
+	State& s,
+	const Closure* const c,
+	size_t dp) {
+
+	s.mem[dp] += word_t(c->imm);
+	retire(s, dp, CLOSURE_IP(c));
+	return dp;
+}
+
+static size_t opSetWord(
+	State& s,
+	const Closure* const c,
+	size_t dp) {
+
+	s.mem[dp] = word_t(c->imm);
+	retire(s, dp, CLOSURE_IP(c));
+	return dp;
+}
+
+static size_t opMovePtr(
+	State& s,
+	const Closure* const c,
+	size_t dp) {
+
+	dp += c->imm;
+	retire(s, dp, CLOSURE_IP(c));
+	return dp;
+}
+
+static size_t opMulAdd(
+	State& s,
+	const Closure* const c,
+	size_t dp) {
+
+#if ENABLE_DIAGNOSTICS
+	if (0 != s.mem[dp] && dp + c->imm >= s.dataLength) {
+		dp += c->imm;
+		retire(s, dp, CLOSURE_IP(c));
+		return dp;
+	}
+
+#endif
+	s.mem[dp + c->imm] += s.mem[dp] * word_t(c->value);
+	retire(s, dp, CLOSURE_IP(c));
+	return dp;
+}
+
+static size_t opScan(
+	State& s,
+	const Closure* const c,
+	size_t dp) {
+
+	if (0 < c->imm)
+		dp = scan::seek_zero_fwd(s.mem, s.dataLength, dp, size_t(c->imm));
+	else
+		dp = scan::seek_zero_rev(s.mem, s.dataLength, dp, size_t(-c->imm));
+	retire(s, dp, CLOSURE_IP(c));
+	return dp;
+}
+
+static size_t opInput(
+	State& s,
+	const Closure* const c,
+	size_t dp) {
+
+	int input;
+	stream::cin >> input;
+	s.mem[dp] = word_t(input);
+	retire(s, dp, CLOSURE_IP(c));
+	return dp;
+}
+
+static size_t opOutput(
+	State& s,
+	const Closure* const c,
+	size_t dp) {
+
+	print(s.mem[dp], s.print_ascii);
+	retire(s, dp, CLOSURE_IP(c));
+	return dp;
+}
+
+static size_t opAddWordAt(
+	State& s,
+	const Closure* const c,
+	size_t dp) {
+
+#if ENABLE_DIAGNOSTICS
+	if (dp + c->imm >= s.dataLength) {
+		dp += c->imm;
+		retire(s, dp, CLOSURE_IP(c));
+		return dp;
+	}
+
+#endif
+	s.mem[dp + c->imm] += word_t(c->value);
+	retire(s, dp, CLOSURE_IP(c));
+	return dp;
+}
+
+static size_t opInputAt(
+	State& s,
+	const Closure* const c,
+	size_t dp) {
+
+#if ENABLE_DIAGNOSTICS
+	if (dp + c->imm >= s.dataLength) {
+		dp += c->imm;
+		retire(s, dp, CLOSURE_IP(c));
+		return dp;
+	}
+
+#endif
+	int input;
+	stream::cin >> input;
+	s.mem[dp + c->imm] = word_t(input);
+	retire(s, dp, CLOSURE_IP(c));
+	return dp;
+}
+
+static size_t opOutputAt(
+	State& s,
+	const Closure* const c,
+	size_t dp) {
+
+#if ENABLE_DIAGNOSTICS
+	if (dp + c->imm >= s.dataLength) {
+		dp += c->imm;
+		retire(s, dp, CLOSURE_IP(c));
+		return dp;
+	}
+
+#endif
+	print(s.mem[dp + c->imm], s.print_ascii);
+	retire(s, dp, CLOSURE_IP(c));
+	return dp;
+}
+
+// run a loop off its node: the loop head and each loop tail retire as a command of their own, at the
+// positions of the original brackets, the tail being imm words past the head
+static size_t opLoop(
+	State& s,
+	const Closure* const c,
+	size_t dp) {
+
+	const Closure* const body = c->body;
+
+#if ENABLE_DIAGNOSTICS
+	if (retire(s, dp, c->ip))
+		return dp;
+
+	while (0 != s.mem[dp]) {
+		dp = runBody(s, body, dp);
+
+		if (s.halt || retire(s, dp, c->ip + c->imm))
+			break;
+	}
+
+#else
+	while (0 != s.mem[dp])
+		dp = runBody(s, body, dp);
+
+#endif
+	return dp;
+}
+
+#undef CLOSURE_IP
+
+// count the closures of the source span [begin, end) at its own nesting level; inner loops count as one each
+template < typename COMMAND_T >
+static size_t countSpan(
+	const COMMAND_T* const program,
+	const size_t begin,
+	const size_t end) {
+
+	size_t count = 0;
+
+	for (size_t i = begin; i < end; ++i, ++count)
+		switch (program[i].getOp()) {
+		case OPCODE_COND_L:
+			i += program[i].getOffset();
+			break;
+		case OPCODE_MUL_ADD:
+		case OPCODE_SCAN:
+		case OPCODE_ADD_WORD_AT:
+		case OPCODE_INPUT_AT:
+		case OPCODE_OUTPUT_AT:
+			++i;
+			break;
+		default:
+			break;
+		}
+
+	return count;
+}
+
+// bind the source span [begin, end) to the body at closure[at], followed by its null handler; the bodies of
+// inner loops go right past that; return the closure index past all bodies bound
+template < typename COMMAND_T >
+static size_t bindSpan(
+	const COMMAND_T* const program,
+	const size_t begin,
+	const size_t end,
+	Closure* const closure,
+	size_t at) {
+
+	size_t next = at + countSpan(program, begin, end) + 1;
+
+	for (size_t i = begin; i < end; ++i, ++at) {
+		const COMMAND_T cmd = program[i];
+		Closure& c = closure[at];
+
+#if ENABLE_DIAGNOSTICS
+		c.ip = i;
+
+#endif
+		switch (cmd.getOp()) {
+		case OPCODE_ADD_WORD:
+			c.handler = opAddWord;
+			c.imm = ptrdiff_t(word_t(cmd.getArith()));
+			break;
+		case OPCODE_SET_WORD:
+			c.handler = opSetWord;
+			c.imm = ptrdiff_t(word_t(cmd.getOffset()));
+			break;
+		case OPCODE_ADD_PTR:
+			c.handler = opMovePtr;
+			c.imm = ptrdiff_t(cmd.getArith());
+			break;
+		case OPCODE_SUB_PTR:
+			c.handler = opMovePtr;
+			c.imm = -ptrdiff_t(cmd.getArith());
+			break;
+		case OPCODE_COND_L:
+			c.handler = opLoop;
+			c.imm = ptrdiff_t(cmd.getOffset());
+			c.body = closure + next;
+			next = bindSpan(program, i + 1, i + cmd.getOffset(), closure, next);
+			i += cmd.getOffset();
+			break;
+		case OPCODE_COND_R:
+			// unreachable: loop tails get consumed along with their heads
+			assert(false);
+			break;
+		case OPCODE_INPUT:
+			c.handler = opInput;
+			break;
+		case OPCODE_OUTPUT:
+			c.handler = opOutput;
+			break;
+		case OPCODE_MUL_ADD:
+			c.handler = opMulAdd;
+			c.imm = program[++i].getDisp();
+			c.value = program[i].getValue();
+			break;
+		case OPCODE_SCAN:
+			c.handler = opScan;
+			c.imm = program[++i].getDisp();
+			break;
+		case OPCODE_ADD_WORD_AT:
+			c.handler = opAddWordAt;
+			c.imm = program[++i].getDisp();
+			c.value = program[i].getValue();
+			break;
+		case OPCODE_INPUT_AT:
+			c.handler = opInputAt;
+			c.imm = program[++i].getDisp();
+			break;
+		case OPCODE_OUTPUT_AT:
+			c.handler = opOutputAt;
+			c.imm = program[++i].getDisp();
+			break;
+		}
+	}
+
+	closure[at].handler = 0;
+	return next;
+}
+
+// run a program of either command form off code, with the data memory right past the program; the
+// program gets bound to a tree of closures along its bracket structure, so each loop node runs its own
+// body, and only straight-line ops go through an indirect call
+template < typename COMMAND_T >
+static int run(
+	const COMMAND_T* const code,
+	const size_t programLength,
+	const size_t dataLength,
+	const uint64_t terminalCount,
+	const bool print_ascii) {
+
+	using testbed::scoped_ptr;
+
+	const Ptr< const COMMAND_T > program(code);
+	const AlignedPtr< word_t, cacheline_size > mem(uintptr_t(code + programLength) + fold_range * sizeof(word_t));
+
+	// every command binds to at most one closure, and every loop tail makes way for the null handler
+	// ending a body, so the top-level null handler brings the count to the program length plus one
+	const scoped_ptr< Closure, generic_free > closure(
+		reinterpret_cast< Closure* >(std::calloc(programLength + 1, sizeof(Closure))));
+
+	if (0 == closure()) {
+		stream::cerr << "failed to provide closure-tree memory\n";
+		return -1;
+	}
+
+	bindSpan(program(), 0, programLength, closure(), 0);
+
+	State s;
+	s.mem = mem();
+	s.dataLength = dataLength;
+	s.print_ascii = print_ascii;
+
+#if ENABLE_DIAGNOSTICS
+	s.terminalCount = terminalCount;
+	s.count = 0;
+	s.ip = 0;
+	s.halt = false;
+
+	size_t dp = 0;
+
+	if (0 != terminalCount && dp < dataLength)
+		dp = runBody(s, closure(), dp);
+
+	if (dp >= dataLength) {
+		stream::cerr << "program error: out-of-bounds data pointer at ip " << s.ip << '\n';
+		return -1;
+	}
+
+	stream::cout << "\ninstructions executed: " << s.count << '\n';
+
+#else
+	(void) terminalCount;
+	runBody(s, closure(), 0);
+
+#endif
+	return 0;
+}
+
+// run the compact form of the program whenever that fits, for its cache density
+static int interpret(
+	const Command32* const wide,
+	const size_t programLength,
+	void* const space,
+	const size_t dataLength,
+	const cli_param& param) {
+
+	const bool print_ascii = bool(param.flags & cli_param::FLAG_PRINT_ASCII);
+	const AlignedPtr< Command16, mempage_size > code16((uintptr_t(space)));
+
+	if (narrow(wide, programLength, code16()))
+		return run(code16(), programLength, dataLength, param.terminalCount, print_ascii);
+
+	const AlignedPtr< Command32, mempage_size > code32((uintptr_t(space)));
+	std::memcpy(code32(), wide, programLength * sizeof(Command32));
+
+	return run(code32(), programLength, dataLength, param.terminalCount, print_ascii);
+}
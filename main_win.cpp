@@ -0,0 +1,256 @@
+#define NIBBLE_OPCODE 1
+#include "frontend.hpp"
+
+// register window: a run of adjacent words packed in a machine register, rotated such that the word at
+// the data pointer sits in lane 0; as rotation keeps the lanes in cyclic order, the word at displacement
+// disp from the data pointer sits in lane disp mod window_lanes, as long as it falls in the window
+typedef uint64_t window_t;
+
+static const size_t window_lanes = sizeof(window_t) / sizeof(word_t);
+static const size_t lane_bits = sizeof(word_t) * 8;
+
+const compile_assert< 0 == (window_lanes & (window_lanes - 1)) > assert_window_lanes;
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error register window assumes little-endian lane order
+#endif
+
+// rotate a window by the given number of lanes towards lane 0, ie. to the right
+static inline window_t rotateWindow(
+	const window_t win,
+	const size_t lanes) {
+
+	const size_t shift = (lanes & (window_lanes - 1)) * lane_bits;
+	return (win >> shift) | (win << ((sizeof(window_t) * 8 - shift) & (sizeof(window_t) * 8 - 1)));
+}
+
+// word at the given lane of a window
+static inline word_t getLane(
+	const window_t win,
+	const size_t lane) {
+
+	return word_t(win >> (lane & (window_lanes - 1)) * lane_bits);
+}
+
+// window with the word at the given lane replaced
+static inline window_t setLane(
+	const window_t win,
+	const size_t lane,
+	const word_t word) {
+
+	const size_t shift = (lane & (window_lanes - 1)) * lane_bits;
+	return (win & ~(window_t(word_t(-1)) << shift)) | (window_t(word) << shift);
+}
+
+// load the window around the data pointer, off base wb, and rotate it to the data pointer
+static inline window_t fillWindow(
+	const word_t* const mem,
+	const size_t dp,
+	size_t& wb) {
+
+	wb = dp < window_lanes / 2 ? 0 : dp - window_lanes / 2;
+
+	window_t win;
+	std::memcpy(&win, mem + wb, sizeof(win));
+	return rotateWindow(win, dp - wb);
+}
+
+// store the window at base wb, unrotating it from the data pointer
+static inline void spillWindow(
+	word_t* const mem,
+	const size_t dp,
+	const size_t wb,
+	const window_t win) {
+
+	const window_t unrotated = rotateWindow(win, window_lanes - (dp - wb));
+	std::memcpy(mem + wb, &unrotated, sizeof(unrotated));
+}
+
+// run a program of either command form off code, with the data memory right past the program; the words
+// around the data pointer live in a register window, and memory gets accessed only when the data pointer
+// leaves the window, or when an op reaches past the window
+template < typename COMMAND_T >
+static int run(
+	const COMMAND_T* const code,
+	const size_t programLength,
+	const size_t dataLength,
+	const uint64_t terminalCount,
+	const bool print_ascii) {
+
+	const Ptr< const COMMAND_T > program(code);
+	const AlignedPtr< word_t, cacheline_size > mem(uintptr_t(code + programLength) + fold_range * sizeof(word_t));
+
+	uint64_t count = 0;
+	size_t ip = 0;
+	size_t dp = 0;
+	size_t wb;
+	window_t win = fillWindow(mem(), dp, wb);
+
+#if ENABLE_DIAGNOSTICS
+	while (count < terminalCount &&
+		   ip < programLength &&
+		   dp < dataLength) {
+
+#else
+	(void) terminalCount;
+
+	while (ip < programLength) {
+
+#endif
+		const word_t cell = getLane(win, 0);
+		const size_t cell_mask = cell ? -1 : 0;
+		const COMMAND_T cmd = program()[ip];
+		int input;
+		size_t to;
+		ptrdiff_t disp;
+
+		switch (cmd.getOp()) {
+		case OPCODE_ADD_WORD:
+			win = setLane(win, 0, cell + word_t(cmd.getImm()));
+			break;
+		case OPCODE_SET_WORD:
+			win = setLane(win, 0, word_t(cmd.getImm()));
+			break;
+		case OPCODE_MUL_ADD:
+			disp = program()[ip + 1].getDisp();
+
+#if ENABLE_DIAGNOSTICS
+			if (0 != cell && dp + disp >= dataLength) {
+				spillWindow(mem(), dp, wb, win);
+				dp += disp;
+				break;
+			}
+
+#endif
+			++ip;
+			if (dp + disp - wb < window_lanes)
+				win = setLane(win, disp, getLane(win, disp) + cell * program()[ip].getValue());
+			else
+				mem()[dp + disp] += cell * program()[ip].getValue();
+			break;
+		case OPCODE_ADD_PTR:
+		case OPCODE_SUB_PTR:
+			disp = OPCODE_ADD_PTR == cmd.getOp() ? ptrdiff_t(cmd.getImm()) : -ptrdiff_t(cmd.getImm());
+			to = dp + disp;
+
+			if (to - wb < window_lanes) {
+				win = rotateWindow(win, disp);
+				dp = to;
+				break;
+			}
+
+			spillWindow(mem(), dp, wb, win);
+			dp = to;
+			win = fillWindow(mem(), dp, wb);
+			break;
+		case OPCODE_COND_L:
+			ip += cmd.getImm() & ~cell_mask;
+			break;
+		case OPCODE_COND_R:
+			ip -= cmd.getImm() & cell_mask;
+			break;
+		case OPCODE_SCAN:
+			spillWindow(mem(), dp, wb, win);
+			++ip;
+			if (0 < program()[ip].getDisp())
+				dp = scan::seek_zero_fwd(mem(), dataLength, dp, size_t(program()[ip].getDisp()));
+			else
+				dp = scan::seek_zero_rev(mem(), dataLength, dp, size_t(-program()[ip].getDisp()));
+			win = fillWindow(mem(), dp, wb);
+			break;
+		case OPCODE_INPUT:
+			stream::cin >> input;
+			win = setLane(win, 0, word_t(input));
+			break;
+		case OPCODE_OUTPUT:
+			print(cell, print_ascii);
+			break;
+		case OPCODE_ADD_WORD_AT:
+			disp = program()[ip + 1].getDisp();
+
+#if ENABLE_DIAGNOSTICS
+			if (dp + disp >= dataLength) {
+				spillWindow(mem(), dp, wb, win);
+				dp += disp;
+				break;
+			}
+
+#endif
+			++ip;
+			if (dp + disp - wb < window_lanes)
+				win = setLane(win, disp, getLane(win, disp) + program()[ip].getValue());
+			else
+				mem()[dp + disp] += program()[ip].getValue();
+			break;
+		case OPCODE_INPUT_AT:
+			disp = program()[ip + 1].getDisp();
+
+#if ENABLE_DIAGNOSTICS
+			if (dp + disp >= dataLength) {
+				spillWindow(mem(), dp, wb, win);
+				dp += disp;
+				break;
+			}
+
+#endif
+			++ip;
+			stream::cin >> input;
+			if (dp + disp - wb < window_lanes)
+				win = setLane(win, disp, word_t(input));
+			else
+				mem()[dp + disp] = word_t(input);
+			break;
+		case OPCODE_OUTPUT_AT:
+			disp = program()[ip + 1].getDisp();
+
+#if ENABLE_DIAGNOSTICS
+			if (dp + disp >= dataLength) {
+				spillWindow(mem(), dp, wb, win);
+				dp += disp;
+				break;
+			}
+
+#endif
+			++ip;
+			if (dp + disp - wb < window_lanes)
+				print(getLane(win, disp), print_ascii);
+			else
+				print(mem()[dp + disp], print_ascii);
+			break;
+		}
+
+		++ip;
+		++count;
+	}
+
+#if ENABLE_DIAGNOSTICS
+	if (dp >= dataLength) {
+		stream::cerr << "program error: out-of-bounds data pointer at ip " << ip - 1 << '\n';
+		return -1;
+	}
+
+	stream::cout << "\ninstructions executed: " << count << '\n';
+
+#endif
+	return 0;
+}
+
+// run the compact form of the program whenever that fits, for its cache density
+static int interpret(
+	const Command32* const wide,
+	const size_t programLength,
+	void* const space,
+	const size_t dataLength,
+	const cli_param& param) {
+
+	const bool print_ascii = bool(param.flags & cli_param::FLAG_PRINT_ASCII);
+	const AlignedPtr< Command16, mempage_size > code16((uintptr_t(space)));
+
+	if (narrow(wide, programLength, code16()))
+		return run(code16(), programLength, dataLength, param.terminalCount, print_ascii);
+
+	const AlignedPtr< Command32, mempage_size > code32((uintptr_t(space)));
+	std::memcpy(code32(), wide, programLength * sizeof(Command32));
+
+	return run(code32(), programLength, dataLength, param.terminalCount, print_ascii);
+}
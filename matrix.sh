@@ -4,21 +4,23 @@ set -euo pipefail
 
 cxxs=(g++-7 g++-8 g++-9 clang++-7 clang++-8 clang++-9)
 
-names=(vanilla alt alt_alt)
-suffixes=('' _alt _alt_alt)
+# versions by build script and suffix; the _pgo ones get profile-guided and link-time optimised
+names=(vanilla alt alt_alt thr cnp tree tail win soa vanilla_pgo alt_pgo alt_alt_pgo)
+suffixes=('' _alt _alt_alt _thr _cnp _tree _tail _win _soa '' _alt _alt_alt)
+builds=(build build build build build build build build build build_pgo build_pgo build_pgo)
 
 for s in cxx "${names[@]}"; do
-	printf "%-9s  " "$s"
+	printf "%-11s  " "$s"
 done
 
 echo
 
 for cxx in "${cxxs[@]}"; do
-	printf "%-9s  " "$cxx"
-	for suffix in "${suffixes[@]}"; do
-		CXX=$cxx ./build.sh $suffix
+	printf "%-11s  " "$cxx"
+	for i in "${!suffixes[@]}"; do
+		CXX=$cxx ./${builds[$i]}.sh ${suffixes[$i]}
 		`which time` -f%E ./brinterp mandelbrot.bf 2>&1 >/dev/null | tr -d '\n'
-		echo -n "    "
+		echo -n "      "
 	done
 	echo
 done
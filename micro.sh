@@ -0,0 +1,61 @@
+#!/bin/bash
+
+set -euo pipefail
+
+# usage: micro.sh [<runs>]; generates the bfgen workloads, and prints the ns and core cycles per executed Command
+# of every version on each, best of that many runs; the Commands get counted by a diagnostics build of the
+# vanilla version, so all versions go by the same count
+runs=${1:-3}
+CXX=${CXX:-g++}
+
+kinds=(add ping_pong nest scan mul output huge)
+names=(vanilla alt alt_alt thr cnp tree tail win soa)
+suffixes=('' _alt _alt_alt _thr _cnp _tree _tail _win _soa)
+
+dir=`mktemp -d`
+trap 'rm -rf "$dir"' EXIT
+
+$CXX -O2 bfgen.cpp -o "$dir/bfgen"
+
+for k in "${kinds[@]}"; do
+	"$dir/bfgen" $k > "$dir/$k.bf"
+done
+
+EXTRA_CXXFLAGS="-UENABLE_DIAGNOSTICS -DENABLE_DIAGNOSTICS=1" ./build.sh
+mv brinterp "$dir/count"
+
+count=()
+
+for k in "${kinds[@]}"; do
+	count+=(`"$dir/count" -terminal_count 18446744073709551615 "$dir/$k.bf" | tail -n 1 | tr -dc 0-9`)
+done
+
+# core clock, as measured for the run statistics of the vanilla version; cycles are ns x GHz
+./build.sh
+ghz=`./brinterp -repeat 1 hello.bf 2>&1 >/dev/null | tail -n 1 | sed 's/.*"ghz": \([0-9.]*\).*/\1/'`
+
+echo "ns / core cycles per executed Command, at a core clock of $ghz GHz"
+
+for s in version "${kinds[@]}"; do
+	printf "%-11s  " "$s"
+done
+
+echo
+
+for i in "${!suffixes[@]}"; do
+	./build.sh ${suffixes[$i]}
+	printf "%-11s  " "${names[$i]}"
+	for j in "${!kinds[@]}"; do
+		best=
+		for r in `seq $runs`; do
+			start=`date +%s%N`
+			./brinterp "$dir/${kinds[$j]}.bf" >/dev/null
+			t=$((`date +%s%N` - start))
+			if [[ -z $best || $t -lt $best ]] ; then
+				best=$t
+			fi
+		done
+		awk "BEGIN { printf \"%-11s  \", sprintf(\"%.2f/%.2f\", $best / ${count[$j]}, $best * $ghz / ${count[$j]}) }"
+	done
+	echo
+done
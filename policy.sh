@@ -0,0 +1,31 @@
+#!/bin/bash
+
+set -euo pipefail
+
+cxxs=(g++-7 g++-8 g++-9 clang++-7 clang++-8 clang++-9)
+
+# policy indices of the pol version: sum of 1: cached word, 2: branchless branches, 4: assumed opcode range
+names=(--- c-- -b- cb- --a c-a -ba cba)
+policies=(0 1 2 3 4 5 6 7)
+
+for s in cxx "${names[@]}" best; do
+	printf "%-9s  " "$s"
+done
+
+echo
+
+for cxx in "${cxxs[@]}"; do
+	printf "%-9s  " "$cxx"
+	CXX=$cxx ./build.sh _pol
+	best=
+	best_time=
+	for policy in "${policies[@]}"; do
+		t=`{ \`which time\` -f%e ./brinterp -policy $policy mandelbrot.bf >/dev/null; } 2>&1`
+		printf "%-9s  " "$t"
+		if [[ -z $best_time ]] || awk "BEGIN { exit !($t < $best_time) }" ; then
+			best=${names[$policy]}
+			best_time=$t
+		fi
+	done
+	echo "$best"
+done
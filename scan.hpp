@@ -0,0 +1,160 @@
+#ifndef scan_H__
+#define scan_H__
+
+#include <stdint.h>
+#include <string.h>
+#if __AVX2__ || __SSE2__
+#include <immintrin.h>
+#endif
+
+namespace scan {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// seek_zero_fwd and seek_zero_rev find the nearest zero byte in an aligned buffer, visiting every
+// stride-th byte forwards or backwards from pos, respectively. The buffer must be aligned to, and
+// padded past length by, no less than vector_size bytes. Upon failure to find a zero, the returned
+// position is the first visited one past the buffer, i.e. at or beyond length forwards, and
+// wrapped around beyond size_t(-1) backwards.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if __AVX2__
+enum { vector_size = 32 };
+
+static inline uint32_t zero_mask(const uint8_t* const p) {
+	const __m256i v = _mm256_load_si256(reinterpret_cast< const __m256i* >(p));
+	return uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256())));
+}
+
+#elif __SSE2__
+enum { vector_size = 16 };
+
+static inline uint32_t zero_mask(const uint8_t* const p) {
+	const __m128i v = _mm_load_si128(reinterpret_cast< const __m128i* >(p));
+	return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())));
+}
+
+#else
+enum { vector_size = 1 };
+
+#endif
+#if __AVX2__ || __SSE2__
+// lanes of a vector, as a bitmask
+static const uint64_t lanes = (uint64_t(1) << vector_size) - 1;
+
+// bitmask of every stride-th lane, starting at lane 0
+static inline uint64_t comb(const size_t stride) {
+	uint64_t m = 1;
+
+	for (size_t span = stride; span < 64; span *= 2)
+		m |= m << span;
+
+	return m;
+}
+
+#endif
+static size_t seek_zero_fwd(
+	const uint8_t* const mem,
+	const size_t length,
+	size_t pos,
+	const size_t stride) {
+
+	if (pos >= length)
+		return pos;
+
+	if (1 == stride) {
+		const void* const hit = memchr(mem + pos, 0, length - pos);
+
+		if (0 != hit)
+			return size_t(static_cast< const uint8_t* >(hit) - mem);
+
+		return length;
+	}
+
+#if __AVX2__ || __SSE2__
+	if (vector_size >= stride) {
+		const uint64_t teeth = comb(stride);
+		const size_t carry = vector_size % stride; // lane shift of the teeth from one vector to the next
+		size_t base = pos & ~size_t(vector_size - 1);
+		size_t lane = pos - base;
+
+		while (base < length) {
+			uint64_t hits = (teeth << lane) & lanes & zero_mask(mem + base);
+
+			if (length - base < vector_size)
+				hits &= (uint64_t(1) << (length - base)) - 1;
+
+			if (0 != hits)
+				return base + __builtin_ctzll(hits);
+
+			lane %= stride;
+			lane = lane >= carry ? lane - carry : lane + stride - carry;
+			base += vector_size;
+		}
+
+		return pos + (length - pos + stride - 1) / stride * stride;
+	}
+
+#endif
+	while (pos < length && 0 != mem[pos])
+		pos += stride;
+
+	return pos;
+}
+
+static size_t seek_zero_rev(
+	const uint8_t* const mem,
+	const size_t length,
+	size_t pos,
+	const size_t stride) {
+
+	if (pos >= length)
+		return pos;
+
+#if __GLIBC__
+	if (1 == stride) {
+		const void* const hit = memrchr(mem, 0, pos + 1);
+
+		if (0 != hit)
+			return size_t(static_cast< const uint8_t* >(hit) - mem);
+
+		return size_t(-1);
+	}
+
+#endif
+#if __AVX2__ || __SSE2__
+	if (vector_size >= stride) {
+		const uint64_t teeth = comb(stride);
+		const size_t carry = vector_size % stride;
+		size_t base = pos & ~size_t(vector_size - 1);
+		size_t lane = (pos - base) % stride; // lowest candidate lane
+
+		uint64_t hits = (teeth << lane) & ((uint64_t(2) << (pos - base)) - 1) & zero_mask(mem + base);
+
+		while (0 == hits) {
+			if (0 == base)
+				return pos - (pos / stride + 1) * stride;
+
+			lane += carry;
+			lane = lane >= stride ? lane - stride : lane;
+			base -= vector_size;
+
+			hits = (teeth << lane) & lanes & zero_mask(mem + base);
+		}
+
+		return base + 63 - __builtin_clzll(hits);
+	}
+
+#endif
+	while (0 != mem[pos]) {
+		if (pos < stride)
+			return pos - stride;
+
+		pos -= stride;
+	}
+
+	return pos;
+}
+
+} // namespace scan
+
+#endif // scan_H__
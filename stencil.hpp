@@ -0,0 +1,99 @@
+#ifndef stencil_H__
+#define stencil_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace stencil {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Stencils are the machine code of small functions, one per op, compiled ahead of time from
+// stencils.cpp and extracted into a table by stencil_gen. At run time, their copies get stitched
+// together, and the holes in the copies get patched with the immediates, branch targets and callee
+// addresses of the program. Every stencil takes the current word, the tape and its length as args,
+// and passes them on to its continuation by a tail call; a continuation which ends a stencil gets
+// dropped by stencil_gen, so execution falls through to the next copy.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef void (*entry_t)(uint8_t* word, uint8_t* tape, size_t length);
+
+enum Id {
+	ADD_WORD,
+	ADD_WORD_AT,
+	SET_WORD,
+	MOVE_PTR,
+	MUL_ADD,
+	SCAN_FWD,
+	SCAN_REV,
+	INPUT,
+	INPUT_AT,
+	OUTPUT,
+	OUTPUT_AT,
+	COND_L,
+	COND_R,
+	END,
+
+	ID_COUNT
+};
+
+// holes in the stencils, by the extern symbols they reference
+enum Hole {
+	HOLE_CONT,     // continuation: the next op
+	HOLE_TARGET,   // branch target
+	HOLE_IMM,      // word immediate
+	HOLE_DISP,     // displacement from the current word
+	HOLE_ASCII,    // print in ASCII
+	HOLE_INPUT,    // word input()
+	HOLE_OUTPUT,   // void output(word, print_ascii)
+	HOLE_SEEK_FWD, // size_t seek_zero_fwd(tape, length, pos, stride)
+	HOLE_SEEK_REV, // size_t seek_zero_rev(tape, length, pos, stride)
+
+	HOLE_COUNT
+};
+
+static const char* const id_name[ID_COUNT] = {
+	"stencil_add_word",
+	"stencil_add_word_at",
+	"stencil_set_word",
+	"stencil_move_ptr",
+	"stencil_mul_add",
+	"stencil_scan_fwd",
+	"stencil_scan_rev",
+	"stencil_input",
+	"stencil_input_at",
+	"stencil_output",
+	"stencil_output_at",
+	"stencil_cond_l",
+	"stencil_cond_r",
+	"stencil_end"
+};
+
+static const char* const hole_name[HOLE_COUNT] = {
+	"hole_cont",
+	"hole_target",
+	"hole_imm",
+	"hole_disp",
+	"hole_ascii",
+	"hole_input",
+	"hole_output",
+	"hole_seek_fwd",
+	"hole_seek_rev"
+};
+
+// absolute 64-bit address of the hole's value, plus addend, at offset into the stencil code
+struct Patch {
+	uint32_t offset;
+	uint32_t hole;
+	int64_t addend;
+};
+
+struct Stencil {
+	const uint8_t* code;
+	size_t size;
+	const Patch* patch;
+	size_t count;
+};
+
+} // namespace stencil
+
+#endif // stencil_H__
@@ -0,0 +1,186 @@
+// stencil_gen: extract the stencils of an x86-64 ELF object, built from stencils.cpp, into a C++ table
+#include <stdint.h>
+#include <cstdlib>
+#include <cstring>
+#include <elf.h>
+#include "stream.hpp"
+#include "scoped.hpp"
+#include "util_file.hpp"
+#include "stencil.hpp"
+
+namespace stream {
+// deferred initialization by main()
+in cin;
+out cout;
+out cerr;
+} // namespace stream
+
+template < typename T >
+class generic_free {
+public:
+	void operator()(T* arg) {
+		free(arg);
+	}
+};
+
+// find the symbol of the given name in the symbol table; return 0 if none
+static const Elf64_Sym* findSymbol(
+	const Elf64_Sym* const sym,
+	const size_t symCount,
+	const char* const strtab,
+	const char* const name) {
+
+	for (size_t i = 0; i < symCount; ++i)
+		if (!std::strcmp(strtab + sym[i].st_name, name))
+			return sym + i;
+
+	return 0;
+}
+
+// find the hole of the given symbol name; return HOLE_COUNT if none
+static size_t findHole(const char* const name) {
+	size_t hole = 0;
+
+	while (hole < stencil::HOLE_COUNT && std::strcmp(stencil::hole_name[hole], name))
+		++hole;
+
+	return hole;
+}
+
+// is the code [0, size) ending with a continuation through the relocation at offset, ie. movabs reg, hole_cont; jmp reg?
+static bool isTailCont(
+	const uint8_t* const code,
+	const size_t size,
+	const size_t offset) {
+
+	if (offset < 2 || (0x48 != code[offset - 2] && 0x49 != code[offset - 2]) || 0xb8 != (code[offset - 1] & 0xf8))
+		return false;
+
+	const size_t tail = offset + sizeof(uint64_t);
+
+	if (tail + 2 == size)
+		return 0xff == code[tail] && 0xe0 == (code[tail + 1] & 0xf8);
+
+	if (tail + 3 == size)
+		return 0x41 == code[tail] && 0xff == code[tail + 1] && 0xe0 == (code[tail + 2] & 0xf8);
+
+	return false;
+}
+
+int main(
+	int argc,
+	char** argv) {
+
+	using testbed::scoped_ptr;
+	using testbed::get_buffer_from_file;
+
+	stream::cin.open(stdin);
+	stream::cout.open(stdout);
+	stream::cerr.open(stderr);
+
+	if (2 != argc) {
+		stream::cerr << "usage: " << argv[0] << " <stencil_object>\n";
+		return 1;
+	}
+
+	size_t length = 0;
+	const scoped_ptr< char, generic_free > file(get_buffer_from_file(argv[1], length));
+
+	if (0 == file()) {
+		stream::cerr << "failed to read stencil object\n";
+		return -1;
+	}
+
+	const uint8_t* const obj = reinterpret_cast< const uint8_t* >(file());
+	const Elf64_Ehdr& ehdr = *reinterpret_cast< const Elf64_Ehdr* >(obj);
+
+	if (length < sizeof(ehdr) || std::memcmp(ehdr.e_ident, ELFMAG, SELFMAG) || ELFCLASS64 != ehdr.e_ident[EI_CLASS] ||
+		ET_REL != ehdr.e_type || EM_X86_64 != ehdr.e_machine) {
+		stream::cerr << "stencil object is not an x86-64 ELF relocatable\n";
+		return -1;
+	}
+
+	const Elf64_Shdr* const shdr = reinterpret_cast< const Elf64_Shdr* >(obj + ehdr.e_shoff);
+	const Elf64_Sym* sym = 0;
+	size_t symCount = 0;
+	const char* strtab = 0;
+
+	for (size_t i = 0; i < ehdr.e_shnum; ++i)
+		if (SHT_SYMTAB == shdr[i].sh_type) {
+			sym = reinterpret_cast< const Elf64_Sym* >(obj + shdr[i].sh_offset);
+			symCount = shdr[i].sh_size / sizeof(Elf64_Sym);
+			strtab = reinterpret_cast< const char* >(obj + shdr[shdr[i].sh_link].sh_offset);
+		}
+
+	if (0 == sym) {
+		stream::cerr << "stencil object has no symbol table\n";
+		return -1;
+	}
+
+	stream::cout << "// generated by stencil_gen from " << argv[1] << "; do not edit\n";
+
+	size_t size[stencil::ID_COUNT];
+	size_t count[stencil::ID_COUNT];
+
+	for (size_t id = 0; id < stencil::ID_COUNT; ++id) {
+		const Elf64_Sym* const fn = findSymbol(sym, symCount, strtab, stencil::id_name[id]);
+
+		if (0 == fn || STT_FUNC != ELF64_ST_TYPE(fn->st_info)) {
+			stream::cerr << "stencil object lacks " << stencil::id_name[id] << '\n';
+			return -1;
+		}
+
+		const uint8_t* const code = obj + shdr[fn->st_shndx].sh_offset + fn->st_value;
+		size[id] = fn->st_size;
+		count[id] = 0;
+
+		stream::cout << "static const stencil::Patch " << stencil::id_name[id] << "_patch[] = {\n";
+
+		// collect the relocations into the function; a tail continuation gets dropped altogether
+		for (size_t i = 0; i < ehdr.e_shnum; ++i) {
+			if (SHT_RELA != shdr[i].sh_type || fn->st_shndx != shdr[i].sh_info)
+				continue;
+
+			const Elf64_Rela* const rela = reinterpret_cast< const Elf64_Rela* >(obj + shdr[i].sh_offset);
+			const size_t relaCount = shdr[i].sh_size / sizeof(Elf64_Rela);
+
+			for (size_t r = 0; r < relaCount; ++r) {
+				if (rela[r].r_offset < fn->st_value || rela[r].r_offset >= fn->st_value + fn->st_size)
+					continue;
+
+				const size_t offset = rela[r].r_offset - fn->st_value;
+				const char* const name = strtab + sym[ELF64_R_SYM(rela[r].r_info)].st_name;
+				const size_t hole = findHole(name);
+
+				if (R_X86_64_64 != ELF64_R_TYPE(rela[r].r_info) || stencil::HOLE_COUNT == hole) {
+					stream::cerr << "unsupported relocation to '" << name << "' in " << stencil::id_name[id] << '\n';
+					return -1;
+				}
+
+				if (stencil::HOLE_CONT == hole && isTailCont(code, fn->st_size, offset)) {
+					size[id] = offset - 2;
+					continue;
+				}
+
+				stream::cout << "\t{ " << uint32_t(offset) << ", " << uint32_t(hole) << ", " << int64_t(rela[r].r_addend) << " },\n";
+				++count[id];
+			}
+		}
+
+		stream::cout << "\t{ 0, 0, 0 }\n};\n";
+		stream::cout << "static const uint8_t " << stencil::id_name[id] << "_code[] = {";
+
+		for (size_t i = 0; i < size[id]; ++i)
+			stream::cout << (i % 16 ? " " : "\n\t") << uint32_t(code[i]) << ',';
+
+		stream::cout << "\n\t0\n};\n";
+	}
+
+	stream::cout << "static const stencil::Stencil stencils[stencil::ID_COUNT] = {\n";
+
+	for (size_t id = 0; id < stencil::ID_COUNT; ++id)
+		stream::cout << "\t{ " << stencil::id_name[id] << "_code, " << size[id] << ", " << stencil::id_name[id] << "_patch, " << count[id] << " },\n";
+
+	stream::cout << "};\n";
+	return 0;
+}
@@ -0,0 +1,95 @@
+// stencil sources; these never link into brinterp -- see stencil.hpp
+#include "stencil.hpp"
+
+extern "C" {
+
+extern const char hole_imm[];
+extern const char hole_disp[];
+extern const char hole_ascii[];
+
+void hole_cont(uint8_t* word, uint8_t* tape, size_t length);
+void hole_target(uint8_t* word, uint8_t* tape, size_t length);
+uint8_t hole_input();
+void hole_output(uint8_t word, bool print_ascii);
+size_t hole_seek_fwd(const uint8_t* tape, size_t length, size_t pos, size_t stride);
+size_t hole_seek_rev(const uint8_t* tape, size_t length, size_t pos, size_t stride);
+
+} // extern "C"
+
+// hole values, as patched in
+#define IMM   uint8_t(uintptr_t(hole_imm))
+#define DISP  intptr_t(hole_disp)
+#define ASCII bool(uintptr_t(hole_ascii) & 1)
+
+extern "C" {
+
+void stencil_add_word(uint8_t* word, uint8_t* tape, size_t length) {
+	*word += IMM;
+	hole_cont(word, tape, length);
+}
+
+void stencil_add_word_at(uint8_t* word, uint8_t* tape, size_t length) {
+	word[DISP] += IMM;
+	hole_cont(word, tape, length);
+}
+
+void stencil_set_word(uint8_t* word, uint8_t* tape, size_t length) {
+	*word = IMM;
+	hole_cont(word, tape, length);
+}
+
+void stencil_move_ptr(uint8_t* word, uint8_t* tape, size_t length) {
+	hole_cont(word + DISP, tape, length);
+}
+
+void stencil_mul_add(uint8_t* word, uint8_t* tape, size_t length) {
+	word[DISP] += uint8_t(*word * IMM);
+	hole_cont(word, tape, length);
+}
+
+void stencil_scan_fwd(uint8_t* word, uint8_t* tape, size_t length) {
+	hole_cont(tape + hole_seek_fwd(tape, length, size_t(word - tape), size_t(DISP)), tape, length);
+}
+
+void stencil_scan_rev(uint8_t* word, uint8_t* tape, size_t length) {
+	hole_cont(tape + hole_seek_rev(tape, length, size_t(word - tape), size_t(DISP)), tape, length);
+}
+
+void stencil_input(uint8_t* word, uint8_t* tape, size_t length) {
+	*word = hole_input();
+	hole_cont(word, tape, length);
+}
+
+void stencil_input_at(uint8_t* word, uint8_t* tape, size_t length) {
+	word[DISP] = hole_input();
+	hole_cont(word, tape, length);
+}
+
+void stencil_output(uint8_t* word, uint8_t* tape, size_t length) {
+	hole_output(*word, ASCII);
+	hole_cont(word, tape, length);
+}
+
+void stencil_output_at(uint8_t* word, uint8_t* tape, size_t length) {
+	hole_output(word[DISP], ASCII);
+	hole_cont(word, tape, length);
+}
+
+void stencil_cond_l(uint8_t* word, uint8_t* tape, size_t length) {
+	if (0 == *word)
+		hole_target(word, tape, length);
+	else
+		hole_cont(word, tape, length);
+}
+
+void stencil_cond_r(uint8_t* word, uint8_t* tape, size_t length) {
+	if (0 != *word)
+		hole_target(word, tape, length);
+	else
+		hole_cont(word, tape, length);
+}
+
+void stencil_end(uint8_t*, uint8_t*, size_t) {
+}
+
+} // extern "C"
@@ -0,0 +1,36 @@
+#!/bin/bash
+
+set -euo pipefail
+
+# usage: test.sh [<suffix> ...]; checks diagnostics builds of the versions of the given suffixes, all by
+# default, for the dispatch counts of programs whose translation should get down to a bound
+suffixes=("$@")
+
+if [[ ${#suffixes[@]} -eq 0 ]] ; then
+	suffixes=('' _alt _alt_alt _thr _cnp _tree _tail _win _soa _pol)
+fi
+
+# program, and the most dispatches it may take
+programs=('>+>>-<<<' '+>+<[-]')
+bounds=(3 4)
+
+dir=`mktemp -d`
+trap 'rm -rf "$dir"' EXIT
+failed=0
+
+for s in "${suffixes[@]}"; do
+	EXTRA_CXXFLAGS="-UENABLE_DIAGNOSTICS -DENABLE_DIAGNOSTICS=1" ./build.sh $s
+
+	for i in "${!programs[@]}"; do
+		printf '%s' "${programs[$i]}" > "$dir/test.bf"
+		count=`./brinterp -terminal_count 100 "$dir/test.bf" | tail -n 1 | tr -dc 0-9`
+
+		if [[ $count -gt ${bounds[$i]} ]] ; then
+			echo "version '$s': '${programs[$i]}' took $count dispatches, over ${bounds[$i]}"
+			failed=1
+		fi
+	done
+done
+
+rm -f brinterp
+exit $failed